@@ -9,15 +9,33 @@
 
 // std
 #include <array>
+#ifdef CLI_INPUT_RING
+#include <atomic>
+#endif
 #include <cstdint>
 #include <cstring>
 #include <string_view>
+#if defined(CLI_CAROUSEL) || defined(CLI_HISTORY_SEARCH) || defined(CLI_PERSISTENT_HISTORY)
+#include <type_traits>
+#endif
+#ifdef CLI_TYPED_PARAMETERS
+#include <cfloat>
+#endif
 
 #ifdef CML
 #include <cml/Non_constructible.hpp>
 #include <cml/Non_copyable.hpp>
 #endif
 
+#if (defined(CLI_TYPED_PARAMETERS) || defined(CLI_SUBCOMMANDS) || defined(CLI_COMMAND_CHAINING)) && \
+    !defined(CLI_COMMAND_PARAMETERS)
+#define CLI_COMMAND_PARAMETERS
+#endif
+
+#if (defined(CLI_HISTORY_SEARCH) || defined(CLI_PERSISTENT_HISTORY)) && !defined(CLI_CAROUSEL)
+#define CLI_CAROUSEL
+#endif
+
 #ifdef _WIN32
 #include <Windows.h>
 #undef max
@@ -26,35 +44,53 @@
 
 namespace modules {
 
-class CLI
+// capacities of a session, derive from it and override what the deployment needs:
+//     struct Small_traits : CLI_traits { static constexpr size_t line_buffer_capacity = 32u; };
+//     using Small_CLI = Basic_CLI<Small_traits>;
+struct CLI_traits
 #ifdef CML
-    : private cml::Non_copyable
+    : private cml::Non_constructible
 #endif
 {
-public:
-    struct s
-#ifdef CML
-        : private cml::Non_constructible
-#endif
-    {
 #ifdef CLI_COMMAND_PARAMETERS
-        static constexpr size_t max_parameters_count = 10u;
+    static constexpr size_t max_parameters_count = 10u;
+
+    static constexpr std::string_view invalid_arguments_message = "> Invalid arguments";
+#endif
+    // false for dumb terminals: lines are then redrawn with backspaces and spaces only, no ESC[K / ESC[nD
+    static constexpr bool ansi_terminal = true;
+
+    static constexpr size_t input_buffer_capacity   = 64u;
+    static constexpr size_t line_buffer_capacity    = 128u;
+    static constexpr size_t carousel_arena_capacity = 640u;
+#ifdef CLI_OUTPUT_BUFFER
+    static constexpr size_t output_buffer_capacity = 64u;
+#endif
+#ifdef CLI_BINARY_CHANNEL
+    static constexpr size_t frame_buffer_capacity = 128u;
+#endif
+#ifdef CLI_TASKS
+    static constexpr size_t type_ahead_buffer_capacity = 64u;
+#endif
+#ifdef CLI_HISTORY_SEARCH
+    static constexpr size_t search_pattern_capacity = 32u;
 #endif
-        static constexpr size_t input_buffer_capacity    = 3u;
-        static constexpr size_t line_buffer_capacity     = 128u;
-        static constexpr size_t carousel_buffer_capacity = 5u;
 
 #ifndef CML
-        s()         = delete;
-        s(const s&) = delete;
-        s(s&&)      = delete;
-        ~s()        = delete;
+    CLI_traits()                  = delete;
+    CLI_traits(const CLI_traits&) = delete;
+    CLI_traits(CLI_traits&&)      = delete;
+    ~CLI_traits()                 = delete;
 
-        s& operator=(const s&) = delete;
-        s& operator=(s&&) = delete;
+    CLI_traits& operator=(const CLI_traits&) = delete;
+    CLI_traits& operator=(CLI_traits&&) = delete;
 #endif
-    };
+};
 
+// types and compile time helpers shared by every Basic_CLI instantiation, so tables work with sessions of any capacity
+class CLI_common
+{
+public:
     enum class Echo : uint32_t
     {
         disabled,
@@ -91,440 +127,4163 @@ public:
         void* p_user_data = nullptr;
     };
 
-#ifdef CLI_COMMAND_PARAMETERS
-    struct Callback
+    struct Wait_handler
     {
-        using Function = void (*)(std::string_view a_argv[], size_t a_argc, void* a_p_user_data);
-
-        std::string_view name;
+        using Function = void (*)(void* a_p_user_data);
 
         Function function = nullptr;
         void* p_user_data = nullptr;
     };
-#else
-    struct Callback
-    {
-        using Function = void (*)(void* a_p_user_data);
 
-        std::string_view name;
+#ifdef CLI_PERSISTENT_HISTORY
+    // append-only log of history lines; append returns false when the medium is full, the log is then erased and
+    // rewritten with the lines held in RAM, so it should fit carousel_arena_capacity bytes of records;
+    // iterate goes oldest first and has to skip a record torn by power loss
+    struct History_storage
+    {
+        using Record_function  = void (*)(std::string_view a_record, void* a_p_context);
+        using Append_function  = bool (*)(std::string_view a_record, void* a_p_user_data);
+        using Iterate_function = void (*)(Record_function a_record, void* a_p_context, void* a_p_user_data);
+        using Erase_function   = void (*)(void* a_p_user_data);
 
-        Function function = nullptr;
-        void* p_user_data = nullptr;
+        Append_function append   = nullptr;
+        Iterate_function iterate = nullptr;
+        Erase_function erase     = nullptr;
+        void* p_user_data        = nullptr;
     };
 #endif
 
-public:
-    CLI(const Write_character_handler& a_write_character,
-        const Write_string_handler& a_write_string,
-        const Read_character_handler& a_read_character,
-        New_line_mode_flag a_new_line_mode_input,
-        New_line_mode_flag a_new_line_mode_output)
-        : write_character(a_write_character)
-        , write_string(a_write_string)
-        , read_character(a_read_character)
-        , new_line_mode_input(a_new_line_mode_input)
-        , new_line_mode_output(a_new_line_mode_output)
-        , line_buffer_size(0)
-#ifdef _WIN32
-        , win32_mode(0)
-#endif
+    enum class Update_status : uint32_t
     {
-#ifdef CLI_ASSERT
-        CLI_ASSERT(nullptr != a_write_character.function);
-        CLI_ASSERT(nullptr != a_write_string.function);
-        CLI_ASSERT(nullptr != a_read_character.function);
-#endif
-        memset(this->line_buffer, 0x0u, sizeof(line_buffer));
-#ifdef _WIN32
-        GetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), &(this->win32_mode));
-        SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), ENABLE_VIRTUAL_TERMINAL_INPUT | this->win32_mode);
+        idle,
+        input_consumed,
+        command_executed,
+#ifdef CLI_TASKS
+        // nothing came in but a task has steps left, update() has to be called again without waiting for input
+        task_running
 #endif
-    }
+    };
 
-#ifdef _WIN32
-    ~CLI()
+#ifdef CLI_BINARY_CHANNEL
+    // SLIP framed request:  END | command id (u16, little endian) | argc (u8) | argc * (length (u8) | bytes) | END
+    // SLIP framed response: END | command id (u16, little endian) | Frame_status (u8) | END
+    // command id is get_frame_id() of the command name, adding or renaming other commands doesn't change it and a
+    // host calling a renamed or removed command gets unknown_command rather than running another one;
+    // what the command writes through the session (get_writer()) comes before the response, in frames with the
+    // output status followed by the text; output a callback sends to the port on its own is not framed
+    enum class Frame_status : uint8_t
     {
-        SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), this->win32_mode);
-    }
+        ok,
+        unknown_command,
+        malformed_frame,
+        invalid_arguments,
+        cancelled,
+        failed,
+        output
+    };
 #endif
 
-    template<size_t callbacks_count> void update(std::string_view a_prompt,
-                                                 std::string_view a_command_not_found_message,
-                                                 const std::array<Callback, callbacks_count>& a_callbacks,
-                                                 Echo a_echo)
+#if defined(CLI_TASKS) || defined(CLI_COMMAND_CHAINING)
+    // failed stops a && chain (and a repeat) at this command
+    enum class Command_status : uint32_t
     {
-        char c[s::input_buffer_capacity] = { 0 };
-        size_t r = this->read_character.function(c, sizeof(c) / sizeof(c[0]), this->read_character.p_user_data);
-
-        if (0 != r)
-        {
-#ifdef CLI_CAROUSEL
-            bool escape_handled = false;
+        done,
+#ifdef CLI_TASKS
+        pending,
 #endif
-            for (size_t char_index = 0; char_index < r
-#ifdef CLI_CAROUSEL
-                                        && false == escape_handled
+#ifdef CLI_COMMAND_CHAINING
+        failed
 #endif
-                 ;
-                 char_index++)
-            {
-                switch (c[char_index])
-                {
-                    case '\r': {
-                        if (New_line_mode_flag::cr == this->new_line_mode_input)
-                        {
-                            this->execute(a_prompt, a_command_not_found_message, a_callbacks, a_echo);
-                            this->line_buffer_size = 0;
-                        }
-                    }
-                    break;
-                    case '\n': {
-                        if (New_line_mode_flag::lf == this->new_line_mode_input ||
-                            (static_cast<uint32_t>(this->new_line_mode_input) ==
-                             (static_cast<uint32_t>(CLI::New_line_mode_flag::cr) |
-                              static_cast<uint32_t>(CLI::New_line_mode_flag::lf))))
-                        {
-                            this->execute(a_prompt, a_command_not_found_message, a_callbacks, a_echo);
-                            this->line_buffer_size = 0;
-                        }
-                    }
-                    break;
-                    case '\b':
-                    case 127u: {
-                        if (this->line_buffer_size > 0)
-                        {
-                            this->line_buffer_size--;
-                            this->write_string.function("\b \b", this->write_string.p_user_data);
-                        }
-                    }
-                    break;
-#ifdef CLI_AUTOCOMPLETION
-                    case '\t': {
-#ifdef CLI_ASSERT
-                        CLI_ASSERT(s::line_buffer_capacity > this->line_buffer_size);
+    };
 #endif
-                        size_t indexes_found[callbacks_count];
-                        size_t indexes_found_count = 0;
 
-                        this->line_buffer[this->line_buffer_size] = 0;
-                        for (size_t i = 0; i < a_callbacks.size(); i++)
-                        {
-                            if (std::string_view::npos != a_callbacks[i].name.find(this->line_buffer))
-                            {
-                                indexes_found[indexes_found_count++] = i;
-                            }
-                        }
+#ifdef CLI_TASKS
 
-                        this->clear_line(this->line_buffer_size + a_prompt.length());
-                        this->write_string.function(a_prompt, this->write_string.p_user_data);
-                        this->line_buffer_size = 0;
+    // handed to every call of a command, zeroed before the first one; after Ctrl-C the command is called once more
+    // with cancelled set so it can clean up, its return value is ignored then
+    struct Task_context
+    {
+        uint32_t step = 0;
+        void* p_data  = nullptr;
 
-                        if (1 == indexes_found_count)
-                        {
-                            this->line_buffer_size = a_callbacks[indexes_found[0]].name.length();
+        bool cancelled = false;
+    };
+#endif
 
-                            this->write_string.function(a_callbacks[indexes_found[0]].name,
-                                                        this->write_string.p_user_data);
-                            memcpy(
-                                this->line_buffer, a_callbacks[indexes_found[0]].name.data(), this->line_buffer_size);
-                        }
-                        else if (0 != indexes_found_count)
-                        {
-                            this->write_new_line();
+#if defined(CLI_TYPED_PARAMETERS)
+    struct Argument
+    {
+        enum class Type : uint32_t
+        {
+            string,
+            signed_integer,
+            unsigned_integer,
+            real,
+            keyword
+        };
 
-                            for (size_t i = 0; i < indexes_found_count; i++)
-                            {
-                                this->write_character.function(' ', this->write_character.p_user_data);
-                                this->write_string.function(a_callbacks[indexes_found[i]].name,
-                                                            this->write_string.p_user_data);
-                            }
+        Type type = Type::string;
+        std::string_view token;
 
-                            this->write_new_line();
-                            this->write_string.function(a_prompt, this->write_string.p_user_data);
-                        }
-                    }
-                    break;
+        union
+        {
+            int32_t signed_integer = 0;
+            uint32_t unsigned_integer;
+            float real;
+            uint32_t keyword_index;
+        };
+    };
+
+    // signature - one item per argument, argv[0] is always the command name:
+    //   i - int32_t, u - uint32_t, x - uint32_t in hex (0x prefix is optional), f - float, s - string,
+    //   e(on|off) - keyword, its position lands in Argument::keyword_index,
+    //   numeric items take an optional inclusive range: u[1:100], f[-1.5:1.5],
+    //   * as the last item accepts any number of trailing strings
+    struct Callback
+    {
+#ifdef CLI_TASKS
+        using Function = Command_status (*)(Argument a_argv[],
+                                            size_t a_argc,
+                                            Task_context* a_p_context,
+                                            void* a_p_user_data);
+#elif defined(CLI_COMMAND_CHAINING)
+        using Function = Command_status (*)(Argument a_argv[], size_t a_argc, void* a_p_user_data);
+#else
+        using Function = void (*)(Argument a_argv[], size_t a_argc, void* a_p_user_data);
 #endif
-                    default: {
-                        if (this->line_buffer_size + 1 < s::line_buffer_capacity && '\033' != c[0]
-#ifdef _WIN32
-                            && 0 != c[char_index]
+
+        std::string_view name;
+
+        Function function = nullptr;
+        void* p_user_data = nullptr;
+
+        std::string_view signature;
+#ifdef CLI_SUBCOMMANDS
+        // child table built with make_callbacks_table, see make_group
+        const Callback* p_children = nullptr;
+        size_t children_count      = 0;
+#endif
+    };
+#elif defined(CLI_COMMAND_PARAMETERS)
+    struct Callback
+    {
+#ifdef CLI_TASKS
+        using Function = Command_status (*)(std::string_view a_argv[],
+                                            size_t a_argc,
+                                            Task_context* a_p_context,
+                                            void* a_p_user_data);
+#elif defined(CLI_COMMAND_CHAINING)
+        using Function = Command_status (*)(std::string_view a_argv[], size_t a_argc, void* a_p_user_data);
+#else
+        using Function = void (*)(std::string_view a_argv[], size_t a_argc, void* a_p_user_data);
 #endif
-                        )
-                        {
-                            this->line_buffer[this->line_buffer_size++] = c[char_index];
 
-                            if (Echo::enabled == a_echo)
-                            {
-                                this->write_character.function(c[char_index], this->write_character.p_user_data);
-                            }
-                        }
-#ifdef CLI_CAROUSEL
-                        else if ('\033' == c[0] && '[' == c[1])
-                        {
-                            if (false == this->carousel.is_empty())
-                            {
-                                std::string_view line_data = 'A' == c[2] ?
-                                                                 this->carousel.get_previus() :
-                                                                 ('B' == c[2] ? this->carousel.get_next() : "");
-
-                                if (false == line_data.empty())
-                                {
-                                    this->clear_line(this->line_buffer_size + a_prompt.length());
-                                    this->line_buffer_size = 0;
-
-                                    this->line_buffer_size                    = line_data.length();
-                                    this->line_buffer[this->line_buffer_size] = 0;
-                                    memcpy(this->line_buffer, line_data.data(), this->line_buffer_size);
-
-                                    this->write_string.function(a_prompt, this->write_string.p_user_data);
-                                    this->write_string.function(this->line_buffer, this->write_string.p_user_data);
-
-                                    escape_handled = true;
-                                }
-                            }
-                            break;
-                        }
+        std::string_view name;
+
+        Function function = nullptr;
+        void* p_user_data = nullptr;
+#ifdef CLI_SUBCOMMANDS
+        // child table built with make_callbacks_table, see make_group
+        const Callback* p_children = nullptr;
+        size_t children_count      = 0;
+#endif
+    };
+#else
+    struct Callback
+    {
+#ifdef CLI_TASKS
+        using Function = Command_status (*)(Task_context* a_p_context, void* a_p_user_data);
+#else
+        using Function = void (*)(void* a_p_user_data);
 #endif
-                    }
-                    break;
-                }
-            }
-        }
-    }
 
-private:
-#ifndef CML
-    CLI(const CLI&) = delete;
-    CLI()           = default;
-    CLI(CLI&&)      = default;
+        std::string_view name;
 
-    CLI& operator=(CLI&&) = default;
-    CLI& operator=(const CLI&) = delete;
+        Function function = nullptr;
+        void* p_user_data = nullptr;
+    };
 #endif
 
-    template<size_t callbacks_count> void execute(std::string_view a_prompt,
-                                                  std::string_view a_command_not_found_message,
-                                                  const std::array<Callback, callbacks_count>& a_callbacks,
-                                                  Echo a_echo)
-    {
-#ifdef CLI_COMMAND_PARAMETERS
-        std::string_view argv[s::max_parameters_count];
-        size_t argc = 0;
+#ifdef CLI_INPUT_RING
+    template<size_t capacity> class Input_ring
+#ifdef CML
+        : private cml::Non_copyable
 #endif
-        bool callback_found                       = false;
-        this->line_buffer[this->line_buffer_size] = 0;
+    {
+    public:
+        static_assert(capacity > 0 && 0 == (capacity & (capacity - 1)), "capacity has to be a power of two");
 
-#ifdef CLI_CAROUSEL
-        if (0 != this->line_buffer_size)
+        Input_ring()
+            : write_index(0)
+            , read_index(0)
+            , overrun_count(0)
+            , dropped_count(0)
         {
-            this->carousel.push(this->line_buffer);
         }
-#endif
-        if (Echo::enabled == a_echo)
+
+        // producer side, safe to call from an interrupt or a DMA transfer complete callback
+        bool push(char a_character)
         {
-            this->write_new_line();
-        }
+            const size_t head = this->write_index.load(std::memory_order_relaxed);
 
-#ifdef CLI_COMMAND_PARAMETERS
-        size_t first = 0;
-        std::string_view strv(this->line_buffer);
+            if (capacity == head - this->read_index.load(std::memory_order_acquire))
+            {
+                this->overrun();
+                this->dropped(1u);
+                return false;
+            }
+
+            this->buffer[head & (capacity - 1)] = a_character;
+            this->write_index.store(head + 1, std::memory_order_release);
 
-        while (first < strv.size())
+            return true;
+        }
+
+        size_t push(const char* a_p_data, size_t a_data_size)
         {
-            const size_t second = strv.find_first_of(' ', first);
+            const size_t head = this->write_index.load(std::memory_order_relaxed);
+            const size_t free = capacity - (head - this->read_index.load(std::memory_order_acquire));
+            const size_t size = a_data_size < free ? a_data_size : free;
 
-            if (first != second)
+            for (size_t i = 0; i < size; i++)
             {
-                argv[argc++] = strv.substr(first, second - first);
+                this->buffer[(head + i) & (capacity - 1)] = a_p_data[i];
             }
 
-            if (second == std::string_view::npos)
+            this->write_index.store(head + size, std::memory_order_release);
+
+            if (size < a_data_size)
             {
-                break;
+                this->overrun();
+                this->dropped(a_data_size - size);
             }
 
-            first = second + 1;
+            return size;
         }
 
-        for (size_t i = 0; i < a_callbacks.size() && false == callback_found && this->line_buffer_size > 1; i++)
+        // consumer side
+        size_t pop(char* a_p_buffer, size_t a_buffer_size)
         {
-            if (0 == a_callbacks[i].name.compare(argv[0]))
+            const size_t tail = this->read_index.load(std::memory_order_relaxed);
+            const size_t used = this->write_index.load(std::memory_order_acquire) - tail;
+            const size_t size = a_buffer_size < used ? a_buffer_size : used;
+
+            for (size_t i = 0; i < size; i++)
             {
-                a_callbacks[i].function(argv, argc, a_callbacks[i].p_user_data);
-                callback_found = true;
+                a_p_buffer[i] = this->buffer[(tail + i) & (capacity - 1)];
             }
+
+            this->read_index.store(tail + size, std::memory_order_release);
+
+            return size;
         }
-#else
-        for (size_t i = 0; i < a_callbacks.size() && false == callback_found && this->line_buffer_size > 1; i++)
+
+        static size_t read_character(char* a_p_buffer, size_t a_buffer_size, void* a_p_user_data)
         {
-            if (0 == a_callbacks[i].name.compare(this->line_buffer))
-            {
-                a_callbacks[i].function(a_callbacks[i].p_user_data);
-                callback_found = true;
-            }
+            return static_cast<Input_ring*>(a_p_user_data)->pop(a_p_buffer, a_buffer_size);
         }
-#endif
-        if (false == callback_found && 0 != this->line_buffer_size)
+
+        size_t get_size() const
         {
-            this->write_string.function(a_command_not_found_message, this->write_string.p_user_data);
+            return this->write_index.load(std::memory_order_acquire) - this->read_index.load(std::memory_order_relaxed);
+        }
 
-            this->write_new_line();
+        bool is_empty() const
+        {
+            return 0 == this->get_size();
         }
 
-        this->write_string.function(a_prompt, this->write_string.p_user_data);
-    }
+        uint32_t get_overrun_count() const
+        {
+            return this->overrun_count.load(std::memory_order_relaxed);
+        }
 
-    void write_new_line()
-    {
-        switch (this->new_line_mode_output)
+        uint32_t get_dropped_count() const
         {
-            case New_line_mode_flag::cr: {
-                this->write_character.function('\r', this->write_character.p_user_data);
-            }
-            break;
+            return this->dropped_count.load(std::memory_order_relaxed);
+        }
 
-            case New_line_mode_flag::lf: {
-                this->write_character.function('\n', this->write_character.p_user_data);
-            }
-            break;
-            default: {
-                this->write_string.function("\r\n", this->write_string.p_user_data);
-            }
+#ifndef CML
+    private:
+        Input_ring(const Input_ring&) = delete;
+        Input_ring(Input_ring&&)      = delete;
+
+        Input_ring& operator=(Input_ring&&) = delete;
+        Input_ring& operator=(const Input_ring&) = delete;
+#endif
+
+    private:
+        // counters are written by the producer only, plain load/store keeps them lock-free on every core
+        void overrun()
+        {
+            this->overrun_count.store(this->overrun_count.load(std::memory_order_relaxed) + 1u,
+                                      std::memory_order_relaxed);
         }
-    }
 
-    void clear_line(size_t a_length)
-    {
-        memset(this->line_buffer, ' ', a_length);
-        this->line_buffer[a_length] = 0;
+        void dropped(size_t a_count)
+        {
+            this->dropped_count.store(
+                this->dropped_count.load(std::memory_order_relaxed) + static_cast<uint32_t>(a_count),
+                std::memory_order_relaxed);
+        }
 
-        this->write_character.function('\r', this->write_character.p_user_data);
-        this->write_string.function(this->line_buffer, this->write_string.p_user_data);
-        this->write_character.function('\r', this->write_character.p_user_data);
-    }
+    private:
+        char buffer[capacity];
 
-private:
-#ifdef CLI_CAROUSEL
-    class Carousel
+        std::atomic<size_t> write_index;
+        std::atomic<size_t> read_index;
+
+        std::atomic<uint32_t> overrun_count;
+        std::atomic<uint32_t> dropped_count;
+    };
+#endif
+
+#ifdef CLI_REGISTRY
+    // commands added at run time next to the static table, which wins on a name clash; no heap: a dense Callback pool
+    // plus an open addressing hash index. Call it from the main loop, not from an interrupt; names are not copied,
+    // they have to outlive the registration
+    class Registry_base
 #ifdef CML
         : private cml::Non_copyable
 #endif
     {
     public:
-        Carousel()
-            : read_index(0)
-            , write_index(0)
-            , buffer_size(0)
+        // false when the pool is full, the name is empty or already registered (or the signature is invalid)
+        bool register_command(const Callback& a_callback)
         {
-            for (size_t i = 0; i < s::carousel_buffer_capacity; i++)
+            if (true == a_callback.name.empty() || this->pool_capacity == this->count ||
+                nullptr != this->find(a_callback.name)
+#ifdef CLI_TYPED_PARAMETERS
+                || false == is_signature_valid(a_callback.signature)
+#endif
+            )
+            {
+                return false;
+            }
+
+            size_t slot = get_hash(a_callback.name) & this->index_mask;
+
+            while (0 != this->p_index[slot])
             {
-                memset(this->buffer[i], 0x0u, sizeof(this->buffer[i]));
+                slot = (slot + 1) & this->index_mask;
             }
+
+            this->p_pool[this->count++] = a_callback;
+            this->p_index[slot]         = static_cast<uint16_t>(this->count);
+
+            return true;
         }
 
-        void push(std::string_view a_data)
+        // a task started by the command keeps running, the session holds its own copy of the function
+        bool unregister_command(std::string_view a_name)
         {
-            this->buffer[this->write_index][a_data.length()] = 0;
-            memcpy(this->buffer[this->write_index++], a_data.data(), a_data.length());
+            const size_t slot = this->find_slot(a_name);
 
-            if (this->write_index == s::carousel_buffer_capacity)
+            if (no_slot == slot)
             {
-                this->write_index = 0;
+                return false;
             }
 
-            if (this->buffer_size < CLI::s::carousel_buffer_capacity)
+            const size_t position = this->p_index[slot] - 1u;
+
+            this->remove_slot(slot);
+            this->count--;
+
+            // the last entry fills the gap, the pool stays dense
+            if (position != this->count)
             {
-                this->buffer_size++;
+                this->p_index[this->find_slot(this->p_pool[this->count].name)] = static_cast<uint16_t>(position + 1u);
+                this->p_pool[position] = this->p_pool[this->count];
             }
+
+            return true;
         }
 
-        std::string_view get_next() const
+        const Callback* find(std::string_view a_name) const
         {
-            std::string_view ret = this->buffer[this->read_index++];
-
-            if (this->buffer_size == this->read_index)
-            {
-                this->read_index = 0;
-            }
+            const size_t slot = this->find_slot(a_name);
 
-            return ret;
+            return no_slot != slot ? this->p_pool + this->p_index[slot] - 1u : nullptr;
         }
 
-        std::string_view get_previus() const
+        // positions are not stable, unregister_command moves the last entry
+        const Callback& get(size_t a_position) const
         {
-#ifdef CLI_ASSERT
-            CLI_ASSERT(this->buffer_size > 0);
-#endif
-            if (0 == this->read_index)
-            {
-                this->read_index = this->buffer_size - 1;
-            }
-            else
-            {
-                this->read_index--;
-            }
+            return this->p_pool[a_position];
+        }
 
-            return this->buffer[this->read_index];
+        size_t get_count() const
+        {
+            return this->count;
         }
 
-        bool is_empty() const
+    protected:
+        Registry_base(Callback* a_p_pool, uint16_t* a_p_index, size_t a_pool_capacity, size_t a_index_capacity)
+            : p_pool(a_p_pool)
+            , p_index(a_p_index)
+            , pool_capacity(a_pool_capacity)
+            , index_mask(a_index_capacity - 1u)
+            , count(0)
         {
-            return 0 == this->buffer_size;
         }
 
 #ifndef CML
     private:
-        Carousel(const Carousel&) = delete;
-        Carousel(Carousel&&)      = default;
+        Registry_base(const Registry_base&) = delete;
+        Registry_base(Registry_base&&)      = delete;
 
-        Carousel& operator=(Carousel&&) = default;
-        Carousel& operator=(const Carousel&) = delete;
+        Registry_base& operator=(Registry_base&&) = delete;
+        Registry_base& operator=(const Registry_base&) = delete;
 #endif
 
     private:
-        char buffer[CLI::s::carousel_buffer_capacity][CLI::s::line_buffer_capacity];
+        static constexpr size_t no_slot = static_cast<size_t>(-1);
 
-        mutable size_t read_index;
-        size_t write_index;
-        size_t buffer_size;
+        // FNV-1a
+        static uint32_t get_hash(std::string_view a_name)
+        {
+            uint32_t ret = 2166136261u;
+
+            for (char c : a_name)
+            {
+                ret = (ret ^ static_cast<uint8_t>(c)) * 16777619u;
+            }
+
+            return ret;
+        }
+
+        size_t find_slot(std::string_view a_name) const
+        {
+            for (size_t slot = get_hash(a_name) & this->index_mask; 0 != this->p_index[slot];
+                 slot        = (slot + 1) & this->index_mask)
+            {
+                if (this->p_pool[this->p_index[slot] - 1u].name == a_name)
+                {
+                    return slot;
+                }
+            }
+
+            return no_slot;
+        }
+
+        // backward shift deletion: entries of the same probe run move into the hole, no tombstones needed
+        void remove_slot(size_t a_slot)
+        {
+            size_t hole = a_slot;
+
+            for (size_t slot = (a_slot + 1) & this->index_mask; 0 != this->p_index[slot];
+                 slot        = (slot + 1) & this->index_mask)
+            {
+                const size_t home = get_hash(this->p_pool[this->p_index[slot] - 1u].name) & this->index_mask;
+
+                if (((slot - home) & this->index_mask) >= ((slot - hole) & this->index_mask))
+                {
+                    this->p_index[hole] = this->p_index[slot];
+                    hole                = slot;
+                }
+            }
+
+            this->p_index[hole] = 0;
+        }
+
+    private:
+        Callback* p_pool;
+        uint16_t* p_index;
+
+        size_t pool_capacity;
+        size_t index_mask;
+        size_t count;
+    };
+
+    template<size_t capacity> class Registry : public Registry_base
+    {
+    public:
+        static_assert(capacity > 0 && capacity < 0xFFFFu, "capacity has to fit the 16 bit index");
+
+        Registry()
+            : Registry_base(this->pool, this->index, capacity, index_capacity)
+        {
+            memset(this->index, 0x0u, sizeof(this->index));
+        }
+
+    private:
+        // power of two, at most half full so probe runs stay short
+        static constexpr size_t get_index_capacity()
+        {
+            size_t ret = 1u;
+
+            while (ret < 2u * capacity)
+            {
+                ret *= 2u;
+            }
+
+            return ret;
+        }
+
+        static constexpr size_t index_capacity = get_index_capacity();
+
+    private:
+        Callback pool[capacity];
+        uint16_t index[index_capacity];
+    };
+#endif
+
+#ifdef CLI_WRITER
+    // printf free output for callbacks: no heap, no locale, every piece goes to a_write_string in one call;
+    // Basic_CLI::get_writer() binds it to the output buffer and new_line_mode_output of a session
+    class Writer
+    {
+    public:
+        // writes nowhere until a writer obtained from get_writer() is assigned
+        Writer()
+            : write_string({ discard, nullptr })
+            , new_line_mode(New_line_mode_flag::lf)
+        {
+        }
+
+        Writer(const Write_string_handler& a_write_string, New_line_mode_flag a_new_line_mode)
+            : write_string(a_write_string)
+            , new_line_mode(a_new_line_mode)
+        {
+        }
+
+        Writer& write(char a_character)
+        {
+            return this->write(std::string_view(&a_character, 1u));
+        }
+
+        Writer& write(std::string_view a_string)
+        {
+            if (false == a_string.empty())
+            {
+                this->write_string.function(a_string, this->write_string.p_user_data);
+            }
+
+            return *this;
+        }
+
+        Writer& write_new_line()
+        {
+            switch (this->new_line_mode)
+            {
+                case New_line_mode_flag::cr: {
+                    this->write('\r');
+                }
+                break;
+
+                case New_line_mode_flag::lf: {
+                    this->write('\n');
+                }
+                break;
+                default: {
+                    this->write("\r\n");
+                }
+            }
+
+            return *this;
+        }
+
+        // right aligned in a_width columns, with a_fill = '0' the sign goes in front of the zeros
+        Writer& write_signed(int32_t a_value, size_t a_width = 0, char a_fill = ' ')
+        {
+            return this->write_fixed(a_value, 0, a_width, a_fill);
+        }
+
+        Writer& write_unsigned(uint32_t a_value, size_t a_width = 0, char a_fill = ' ')
+        {
+            return this->write_decimal(false, a_value, 0, a_width, a_fill);
+        }
+
+        // a_value / 10^a_fraction_digits: (-1234, 2) writes -12.34, at most 9 fraction digits
+        Writer& write_fixed(int32_t a_value, uint32_t a_fraction_digits, size_t a_width = 0, char a_fill = ' ')
+        {
+            const uint32_t magnitude =
+                a_value < 0 ? 0u - static_cast<uint32_t>(a_value) : static_cast<uint32_t>(a_value);
+
+            return this->write_decimal(a_value < 0, magnitude, a_fraction_digits, a_width, a_fill);
+        }
+
+        // upper case, zero padded to a_digits (at most 8), no prefix
+        Writer& write_hex(uint32_t a_value, size_t a_digits = 0)
+        {
+            char buffer[8];
+            size_t index = sizeof(buffer);
+
+            do
+            {
+                buffer[--index] = "0123456789ABCDEF"[a_value & 0xFu];
+                a_value >>= 4u;
+            } while (index > 0 && (0 != a_value || sizeof(buffer) - index < a_digits));
+
+            return this->write(std::string_view(buffer + index, sizeof(buffer) - index));
+        }
+
+        // left aligned, padded with spaces to a_width columns
+        Writer& write_column(std::string_view a_string, size_t a_width)
+        {
+            this->write(a_string);
+
+            return this->write_repeated(' ', a_width > a_string.length() ? a_width - a_string.length() : 0);
+        }
+
+        // 08000010: 48 65 6C 6C 6F                                   |Hello|
+        Writer& write_hexdump_row(uint32_t a_address, const uint8_t* a_p_data, size_t a_size)
+        {
+            this->write_hex(a_address, 8u).write(": ");
+
+            for (size_t i = 0; i < hexdump_row_size; i++)
+            {
+                if (i < a_size)
+                {
+                    this->write_hex(a_p_data[i], 2u).write(' ');
+                }
+                else
+                {
+                    this->write("   ");
+                }
+            }
+
+            this->write(" |");
+
+            for (size_t i = 0; i < a_size && i < hexdump_row_size; i++)
+            {
+                this->write(a_p_data[i] >= 0x20u && a_p_data[i] < 0x7Fu ? static_cast<char>(a_p_data[i]) : '.');
+            }
+
+            return this->write('|').write_new_line();
+        }
+
+        Writer& write_hexdump(uint32_t a_address, const void* a_p_data, size_t a_size)
+        {
+            const uint8_t* p_data = static_cast<const uint8_t*>(a_p_data);
+
+            for (size_t offset = 0; offset < a_size; offset += hexdump_row_size)
+            {
+                const size_t size = a_size - offset < hexdump_row_size ? a_size - offset : hexdump_row_size;
+
+                this->write_hexdump_row(a_address + static_cast<uint32_t>(offset), p_data + offset, size);
+            }
+
+            return *this;
+        }
+
+    private:
+        static constexpr size_t hexdump_row_size = 16u;
+
+        Writer& write_decimal(bool a_negative,
+                              uint32_t a_magnitude,
+                              uint32_t a_fraction_digits,
+                              size_t a_width,
+                              char a_fill)
+        {
+            char buffer[12];
+            size_t index = sizeof(buffer);
+
+            if (a_fraction_digits > 9u)
+            {
+                a_fraction_digits = 9u;
+            }
+
+            for (uint32_t i = 0; i <= a_fraction_digits || 0 != a_magnitude; i++)
+            {
+                if (0 != a_fraction_digits && i == a_fraction_digits)
+                {
+                    buffer[--index] = '.';
+                }
+
+                buffer[--index] = static_cast<char>('0' + a_magnitude % 10u);
+                a_magnitude /= 10u;
+            }
+
+            const size_t length  = sizeof(buffer) - index + (true == a_negative ? 1u : 0u);
+            const size_t padding = a_width > length ? a_width - length : 0;
+
+            if ('0' != a_fill)
+            {
+                this->write_repeated(a_fill, padding);
+            }
+
+            if (true == a_negative)
+            {
+                this->write('-');
+            }
+
+            if ('0' == a_fill)
+            {
+                this->write_repeated(a_fill, padding);
+            }
+
+            return this->write(std::string_view(buffer + index, sizeof(buffer) - index));
+        }
+
+        Writer& write_repeated(char a_character, size_t a_count)
+        {
+            char chunk[16];
+            memset(chunk, a_character, sizeof(chunk));
+
+            for (; a_count > sizeof(chunk); a_count -= sizeof(chunk))
+            {
+                this->write(std::string_view(chunk, sizeof(chunk)));
+            }
+
+            return this->write(std::string_view(chunk, a_count));
+        }
+
+        static void discard(std::string_view, void*) {}
+
+    private:
+        Write_string_handler write_string;
+        New_line_mode_flag new_line_mode;
+    };
+#endif
+
+public:
+    // callbacks sorted by make_callbacks_table, the only kind of array update() and ingest() take - find() is a binary
+    // search, a hand written array in any other order would miss commands
+    template<size_t callbacks_count> struct Callbacks_table : std::array<Callback, callbacks_count>
+    {
+    };
+
+    // command table shared by every session (one CLI object per port), keep it static constexpr so it stays in flash;
+    // the callbacks are sorted by name for the binary search of find()
+    template<size_t callbacks_count> struct Table
+    {
+        Callbacks_table<callbacks_count> callbacks;
+
+        std::string_view prompt;
+        std::string_view command_not_found_message;
+    };
+
+    // non-owning view of a table, one non-template update() serves tables of every size through it;
+    // the viewed callbacks have to outlive the view
+    struct Table_view
+    {
+        constexpr Table_view() = default;
+
+        template<size_t table_size> constexpr Table_view(const Table<table_size>& a_table)
+            : p_callbacks(a_table.callbacks.data())
+            , callbacks_count(table_size)
+            , prompt(a_table.prompt)
+            , command_not_found_message(a_table.command_not_found_message)
+        {
+        }
+
+        template<size_t table_size> constexpr Table_view(std::string_view a_prompt,
+                                                         std::string_view a_command_not_found_message,
+                                                         const Callbacks_table<table_size>& a_callbacks)
+            : p_callbacks(a_callbacks.data())
+            , callbacks_count(table_size)
+            , prompt(a_prompt)
+            , command_not_found_message(a_command_not_found_message)
+        {
+        }
+
+        const Callback* p_callbacks = nullptr;
+        size_t callbacks_count      = 0;
+
+        std::string_view prompt;
+        std::string_view command_not_found_message;
+    };
+
+    template<size_t callbacks_count> static constexpr Callbacks_table<callbacks_count>
+    make_callbacks_table(const std::array<Callback, callbacks_count>& a_callbacks)
+    {
+        Callbacks_table<callbacks_count> ret { a_callbacks };
+
+        for (size_t i = callbacks_count / 2; i > 0; i--)
+        {
+            sift_down(ret.data(), i - 1, callbacks_count);
+        }
+
+        for (size_t i = callbacks_count; i > 1; i--)
+        {
+            const Callback tmp = ret[0];
+            ret[0]             = ret[i - 1];
+            ret[i - 1]         = tmp;
+
+            sift_down(ret.data(), 0, i - 1);
+        }
+
+        for (size_t i = 1; i < callbacks_count; i++)
+        {
+            if (ret[i - 1].name == ret[i].name)
+            {
+                callback_name_duplicated();
+            }
+        }
+#ifdef CLI_BINARY_CHANNEL
+        for (size_t i = 0; i < callbacks_count; i++)
+        {
+            for (size_t j = i + 1; j < callbacks_count; j++)
+            {
+                if (get_frame_id(ret[i].name) == get_frame_id(ret[j].name))
+                {
+                    callback_frame_id_duplicated();
+                }
+            }
+        }
+#endif
+#ifdef CLI_TYPED_PARAMETERS
+        for (size_t i = 0; i < callbacks_count; i++)
+        {
+            if (false == is_signature_valid(ret[i].signature))
+            {
+                callback_signature_invalid();
+            }
+        }
+#endif
+
+        return ret;
+    }
+
+#ifdef CLI_BINARY_CHANNEL
+    // id a frame calls a command by: FNV-1a of the name folded to 16 bits, the host computes it the same way;
+    // 0xFFFF is left for replies to frames without a readable id
+    static constexpr uint16_t get_frame_id(std::string_view a_name)
+    {
+        uint32_t hash = 2166136261u;
+
+        for (char character : a_name)
+        {
+            hash = (hash ^ static_cast<uint8_t>(character)) * 16777619u;
+        }
+
+        const uint16_t ret = static_cast<uint16_t>((hash >> 16u) ^ (hash & 0xFFFFu));
+
+        return 0xFFFFu == ret ? 0u : ret;
+    }
+#endif
+
+    template<size_t callbacks_count> static constexpr Table<callbacks_count>
+    make_table(std::string_view a_prompt,
+               std::string_view a_command_not_found_message,
+               const std::array<Callback, callbacks_count>& a_callbacks)
+    {
+        return { make_callbacks_table(a_callbacks), a_prompt, a_command_not_found_message };
+    }
+
+#ifdef CLI_SUBCOMMANDS
+    // node of a command tree ("gpio set 3 1"), a_children has to be a static constexpr table built with
+    // make_callbacks_table - the node keeps its address, so the whole tree stays in flash;
+    // a node without a function reports command not found when the next token is not one of its children
+    template<size_t children_count> static constexpr Callback
+    make_group(std::string_view a_name, const std::array<Callback, children_count>& a_children)
+    {
+        if (false == is_sorted(a_children.data(), children_count))
+        {
+            callbacks_table_unsorted();
+        }
+
+        Callback ret {};
+
+        ret.name           = a_name;
+        ret.p_children     = a_children.data();
+        ret.children_count = children_count;
+
+        return ret;
+    }
+#endif
+
+    struct Ingest_result
+    {
+        size_t lines_count = 0;
+        size_t bytes_count = 0;
+    };
+
+protected:
+    CLI_common() = default;
+
+#ifdef CLI_TYPED_PARAMETERS
+    struct Signature_item
+    {
+        char type = 0;
+        std::string_view options;
+    };
+
+    static constexpr bool next_signature_item(std::string_view a_signature,
+                                              size_t* a_p_offset,
+                                              Signature_item* a_p_item)
+    {
+        while (*a_p_offset < a_signature.length() && ' ' == a_signature[*a_p_offset])
+        {
+            (*a_p_offset)++;
+        }
+
+        if (*a_p_offset == a_signature.length())
+        {
+            return false;
+        }
+
+        a_p_item->type    = a_signature[(*a_p_offset)++];
+        a_p_item->options = std::string_view();
+
+        if (*a_p_offset < a_signature.length() &&
+            ('(' == a_signature[*a_p_offset] || '[' == a_signature[*a_p_offset]))
+        {
+            const char closing  = '(' == a_signature[*a_p_offset] ? ')' : ']';
+            const size_t first  = *a_p_offset + 1;
+            const size_t second = a_signature.find_first_of(closing, first);
+
+            if (std::string_view::npos == second)
+            {
+                a_p_item->type = 0;
+                return true;
+            }
+
+            a_p_item->options = a_signature.substr(first, second - first);
+            *a_p_offset       = second + 1;
+        }
+
+        return true;
+    }
+
+    static constexpr bool parse_signed(std::string_view a_token, int32_t* a_p_out)
+    {
+        const bool negative = false == a_token.empty() && '-' == a_token[0];
+        uint32_t magnitude  = 0;
+
+        if (false == a_token.empty() && ('-' == a_token[0] || '+' == a_token[0]))
+        {
+            a_token.remove_prefix(1);
+        }
+
+        if (false == parse_unsigned(a_token, &magnitude) ||
+            magnitude > (true == negative ? 0x80000000u : 0x7FFFFFFFu))
+        {
+            return false;
+        }
+
+        *a_p_out = true == negative ? static_cast<int32_t>(0u - magnitude) : static_cast<int32_t>(magnitude);
+        return true;
+    }
+
+    static constexpr bool parse_unsigned(std::string_view a_token, uint32_t* a_p_out)
+    {
+        uint64_t value = 0;
+
+        for (char c : a_token)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+
+            value = value * 10u + static_cast<uint32_t>(c - '0');
+
+            if (value > 0xFFFFFFFFu)
+            {
+                return false;
+            }
+        }
+
+        *a_p_out = static_cast<uint32_t>(value);
+        return false == a_token.empty();
+    }
+
+    static constexpr bool parse_hex(std::string_view a_token, uint32_t* a_p_out)
+    {
+        uint32_t value = 0;
+
+        if (a_token.length() > 2 && '0' == a_token[0] && ('x' == a_token[1] || 'X' == a_token[1]))
+        {
+            a_token.remove_prefix(2);
+        }
+
+        if (true == a_token.empty() || a_token.length() > 8)
+        {
+            return false;
+        }
+
+        for (char c : a_token)
+        {
+            uint32_t digit = 0;
+
+            if (c >= '0' && c <= '9')
+            {
+                digit = static_cast<uint32_t>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                digit = static_cast<uint32_t>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                digit = static_cast<uint32_t>(c - 'A' + 10);
+            }
+            else
+            {
+                return false;
+            }
+
+            value = (value << 4u) | digit;
+        }
+
+        *a_p_out = value;
+        return true;
+    }
+
+    // accumulated in float, a target without a double precision FPU doesn't pull in the soft double library
+    static constexpr bool parse_real(std::string_view a_token, float* a_p_out)
+    {
+        const bool negative = false == a_token.empty() && '-' == a_token[0];
+        float value         = 0;
+        size_t digits_count = 0;
+        size_t i            = 0;
+
+        if (false == a_token.empty() && ('-' == a_token[0] || '+' == a_token[0]))
+        {
+            i++;
+        }
+
+        for (; i < a_token.length() && a_token[i] >= '0' && a_token[i] <= '9'; i++, digits_count++)
+        {
+            if (value > FLT_MAX / 10.0f)
+            {
+                return false;
+            }
+
+            value = value * 10.0f + static_cast<float>(a_token[i] - '0');
+        }
+
+        if (i < a_token.length() && '.' == a_token[i])
+        {
+            float scale = 0.1f;
+
+            for (i++; i < a_token.length() && a_token[i] >= '0' && a_token[i] <= '9'; i++, digits_count++)
+            {
+                value += static_cast<float>(a_token[i] - '0') * scale;
+                scale /= 10.0f;
+            }
+        }
+
+        if (0 == digits_count)
+        {
+            return false;
+        }
+
+        if (i < a_token.length() && ('e' == a_token[i] || 'E' == a_token[i]))
+        {
+            int32_t exponent = 0;
+
+            if (false == parse_signed(a_token.substr(i + 1), &exponent) || exponent < -45 || exponent > 38)
+            {
+                return false;
+            }
+
+            for (; exponent > 0; exponent--)
+            {
+                if (value > FLT_MAX / 10.0f)
+                {
+                    return false;
+                }
+
+                value *= 10.0f;
+            }
+
+            for (; exponent < 0; exponent++)
+            {
+                value /= 10.0f;
+            }
+
+            i = a_token.length();
+        }
+
+        *a_p_out = true == negative ? -value : value;
+        return i == a_token.length();
+    }
+
+    // range bounds are parsed as the type of the parameter, integers never go through floating point
+    static constexpr bool parse_bound(char, std::string_view a_token, int32_t* a_p_out)
+    {
+        return parse_signed(a_token, a_p_out);
+    }
+
+    static constexpr bool parse_bound(char a_type, std::string_view a_token, uint32_t* a_p_out)
+    {
+        return 'u' == a_type ? parse_unsigned(a_token, a_p_out) : parse_hex(a_token, a_p_out);
+    }
+
+    static constexpr bool parse_bound(char, std::string_view a_token, float* a_p_out)
+    {
+        return parse_real(a_token, a_p_out);
+    }
+
+    template<typename Value>
+    static constexpr bool parse_range(char a_type, std::string_view a_range, Value* a_p_min, Value* a_p_max)
+    {
+        const size_t separator = a_range.find_first_of(':');
+
+        return std::string_view::npos != separator &&
+               true == parse_bound(a_type, a_range.substr(0, separator), a_p_min) &&
+               true == parse_bound(a_type, a_range.substr(separator + 1), a_p_max) && *a_p_min <= *a_p_max;
+    }
+
+    template<typename Value> static constexpr bool is_in_range(char a_type, std::string_view a_range, Value a_value)
+    {
+        Value min = 0;
+        Value max = 0;
+
+        return true == parse_range(a_type, a_range, &min, &max) && a_value >= min && a_value <= max;
+    }
+
+    static bool parse_number(char a_type, std::string_view a_token, Argument* a_p_out)
+    {
+        switch (a_type)
+        {
+            case 'i': {
+                a_p_out->type = Argument::Type::signed_integer;
+                return parse_signed(a_token, &(a_p_out->signed_integer));
+            }
+
+            case 'u': {
+                a_p_out->type = Argument::Type::unsigned_integer;
+                return parse_unsigned(a_token, &(a_p_out->unsigned_integer));
+            }
+
+            case 'x': {
+                a_p_out->type = Argument::Type::unsigned_integer;
+                return parse_hex(a_token, &(a_p_out->unsigned_integer));
+            }
+
+            case 'f': {
+                a_p_out->type = Argument::Type::real;
+                return parse_real(a_token, &(a_p_out->real));
+            }
+        }
+
+        return false;
+    }
+
+    static bool is_in_range(const Argument& a_argument, char a_type, std::string_view a_range)
+    {
+        switch (a_argument.type)
+        {
+            case Argument::Type::signed_integer:
+                return is_in_range(a_type, a_range, a_argument.signed_integer);
+            case Argument::Type::unsigned_integer:
+                return is_in_range(a_type, a_range, a_argument.unsigned_integer);
+            case Argument::Type::real:
+                return is_in_range(a_type, a_range, a_argument.real);
+            default:
+                return false;
+        }
+    }
+
+    static constexpr bool find_keyword(std::string_view a_keywords, std::string_view a_token, uint32_t* a_p_index)
+    {
+        uint32_t index = 0;
+        size_t first   = 0;
+
+        while (first <= a_keywords.length())
+        {
+            size_t second = a_keywords.find_first_of('|', first);
+
+            if (std::string_view::npos == second)
+            {
+                second = a_keywords.length();
+            }
+
+            if (a_keywords.substr(first, second - first) == a_token)
+            {
+                *a_p_index = index;
+                return true;
+            }
+
+            first = second + 1;
+            index++;
+        }
+
+        return false;
+    }
+
+    static constexpr bool is_signature_valid(std::string_view a_signature)
+    {
+        size_t offset = 0;
+        Signature_item item;
+
+        while (true == next_signature_item(a_signature, &offset, &item))
+        {
+            switch (item.type)
+            {
+                case 'i': {
+                    int32_t min = 0;
+                    int32_t max = 0;
+
+                    if (false == item.options.empty() && false == parse_range(item.type, item.options, &min, &max))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case 'u':
+                case 'x': {
+                    uint32_t min = 0;
+                    uint32_t max = 0;
+
+                    if (false == item.options.empty() && false == parse_range(item.type, item.options, &min, &max))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case 'f': {
+                    float min = 0;
+                    float max = 0;
+
+                    if (false == item.options.empty() && false == parse_range(item.type, item.options, &min, &max))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case 'e': {
+                    if (true == item.options.empty() || '|' == item.options.front() || '|' == item.options.back() ||
+                        std::string_view::npos != item.options.find("||"))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case 's': {
+                    if (false == item.options.empty())
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                case '*': {
+                    if (false == item.options.empty() || true == next_signature_item(a_signature, &offset, &item))
+                    {
+                        return false;
+                    }
+                }
+                break;
+
+                default:
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool parse_arguments(std::string_view a_signature,
+                                std::string_view a_argv[],
+                                size_t a_argc,
+                                Argument a_arguments[])
+    {
+        size_t offset = 0;
+        size_t index  = 1;
+        Signature_item item;
+
+        for (size_t i = 0; i < a_argc; i++)
+        {
+            a_arguments[i].type  = Argument::Type::string;
+            a_arguments[i].token = a_argv[i];
+        }
+
+        while (true == next_signature_item(a_signature, &offset, &item))
+        {
+            if ('*' == item.type)
+            {
+                return true;
+            }
+
+            if (index >= a_argc)
+            {
+                return false;
+            }
+
+            if ('e' == item.type)
+            {
+                if (false == find_keyword(item.options, a_argv[index], &(a_arguments[index].keyword_index)))
+                {
+                    return false;
+                }
+
+                a_arguments[index].type = Argument::Type::keyword;
+            }
+            else if ('s' != item.type)
+            {
+                if (false == parse_number(item.type, a_argv[index], a_arguments + index) ||
+                    (false == item.options.empty() &&
+                     false == is_in_range(a_arguments[index], item.type, item.options)))
+                {
+                    return false;
+                }
+            }
+
+            index++;
+        }
+
+        return index == a_argc;
+    }
+
+    // not constexpr on purpose - reaching it during constant evaluation rejects the table at compile time
+    static void callback_signature_invalid()
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(false);
+#endif
+    }
+#endif
+
+    static constexpr bool is_sorted(const Callback* a_p_callbacks, size_t a_callbacks_count)
+    {
+        for (size_t i = 1; i < a_callbacks_count; i++)
+        {
+            if (false == (a_p_callbacks[i - 1].name < a_p_callbacks[i].name))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static constexpr void sift_down(Callback* a_p_callbacks, size_t a_index, size_t a_callbacks_count)
+    {
+        while (2 * a_index + 1 < a_callbacks_count)
+        {
+            size_t child = 2 * a_index + 1;
+
+            if (child + 1 < a_callbacks_count && a_p_callbacks[child].name < a_p_callbacks[child + 1].name)
+            {
+                child++;
+            }
+
+            if (false == (a_p_callbacks[a_index].name < a_p_callbacks[child].name))
+            {
+                return;
+            }
+
+            const Callback tmp     = a_p_callbacks[a_index];
+            a_p_callbacks[a_index] = a_p_callbacks[child];
+            a_p_callbacks[child]   = tmp;
+            a_index                = child;
+        }
+    }
+
+    // not constexpr on purpose - reaching it during constant evaluation rejects the table at compile time
+    static void callback_name_duplicated()
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(false);
+#endif
+    }
+
+#ifdef CLI_BINARY_CHANNEL
+    // not constexpr on purpose - two names with the same frame id reject the table at compile time, rename one
+    static void callback_frame_id_duplicated()
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(false);
+#endif
+    }
+#endif
+
+#ifdef CLI_SUBCOMMANDS
+    // not constexpr on purpose - reaching it during constant evaluation rejects the group at compile time
+    static void callbacks_table_unsorted()
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(false);
+#endif
+    }
+#endif
+};
+
+inline constexpr CLI_common::New_line_mode_flag operator|(CLI_common::New_line_mode_flag a_f1,
+                                                          CLI_common::New_line_mode_flag a_f2)
+{
+    return static_cast<CLI_common::New_line_mode_flag>(static_cast<uint32_t>(a_f1) | static_cast<uint32_t>(a_f2));
+}
+
+inline constexpr CLI_common::New_line_mode_flag operator&(CLI_common::New_line_mode_flag a_f1,
+                                                          CLI_common::New_line_mode_flag a_f2)
+
+{
+    return static_cast<CLI_common::New_line_mode_flag>(static_cast<uint32_t>(a_f1) & static_cast<uint32_t>(a_f2));
+}
+
+inline constexpr CLI_common::New_line_mode_flag operator|=(CLI_common::New_line_mode_flag& a_f1,
+                                                           CLI_common::New_line_mode_flag a_f2)
+{
+    a_f1 = a_f1 | a_f2;
+    return a_f1;
+}
+
+template<typename Traits = CLI_traits> class Basic_CLI
+    : public CLI_common
+#ifdef CML
+    , private cml::Non_copyable
+#endif
+{
+public:
+    using s = Traits;
+
+    static_assert(s::input_buffer_capacity > 0u, "input_buffer_capacity has to be at least 1");
+    static_assert(s::line_buffer_capacity > 1u, "line_buffer_capacity needs room for a character and the terminator");
+#ifdef CLI_COMMAND_PARAMETERS
+    static_assert(s::max_parameters_count > 0u, "max_parameters_count has to leave room for the command name");
+    static_assert(s::max_parameters_count <= s::line_buffer_capacity / 2u + 1u,
+                  "a line can't hold more than line_buffer_capacity / 2 + 1 tokens");
+#endif
+#ifdef CLI_OUTPUT_BUFFER
+    static_assert(s::output_buffer_capacity > 0u, "output_buffer_capacity has to be at least 1");
+#endif
+#ifdef CLI_BINARY_CHANNEL
+    static_assert(s::frame_buffer_capacity >= 3u, "frame_buffer_capacity has to hold the frame header");
+#ifdef CLI_COMMAND_PARAMETERS
+    static_assert(s::max_parameters_count <= 256u, "frames carry argc in a single byte");
+#endif
+#endif
+#ifdef CLI_TASKS
+    // the rest of an input read is kept when a command read with it starts a task
+    static_assert(s::type_ahead_buffer_capacity >= s::input_buffer_capacity,
+                  "type_ahead_buffer_capacity has to hold an input read");
+#endif
+#ifdef CLI_HISTORY_SEARCH
+    static_assert(s::search_pattern_capacity > 0u, "search_pattern_capacity has to be at least 1");
+#endif
+
+    // RAM taken by one session: the object itself and the largest buffers update() puts on the stack
+    static constexpr size_t get_ram_footprint()
+    {
+        return sizeof(Basic_CLI) + s::input_buffer_capacity
+#ifdef CLI_COMMAND_PARAMETERS
+               + s::max_parameters_count * sizeof(std::string_view)
+#endif
+#if defined(CLI_TYPED_PARAMETERS) && !defined(CLI_TASKS)
+               + s::max_parameters_count * sizeof(Argument)
+#endif
+            ;
+    }
+
+    // a session holds only its handlers, the line buffer, history and the buffers of enabled features,
+    // get_ram_footprint() tells how much that is, footprint.sh reports it for each feature set
+    // a_table is what update(Echo) and ingest() work with, a static constexpr Table converts to it
+    Basic_CLI(const Write_character_handler& a_write_character,
+              const Write_string_handler& a_write_string,
+              const Read_character_handler& a_read_character,
+              New_line_mode_flag a_new_line_mode_input,
+              New_line_mode_flag a_new_line_mode_output,
+              const Table_view& a_table = Table_view())
+        : Basic_CLI(a_write_character,
+                    a_write_string,
+                    a_read_character,
+                    Wait_handler(),
+                    a_new_line_mode_input,
+                    a_new_line_mode_output,
+                    a_table)
+    {
+    }
+
+    // a_wait is called by update() when no input is pending, it may block (WFI, poll) until input arrives
+    Basic_CLI(const Write_character_handler& a_write_character,
+              const Write_string_handler& a_write_string,
+              const Read_character_handler& a_read_character,
+              const Wait_handler& a_wait,
+              New_line_mode_flag a_new_line_mode_input,
+              New_line_mode_flag a_new_line_mode_output,
+              const Table_view& a_table = Table_view())
+        : write_character(a_write_character)
+        , write_string(a_write_string)
+        , read_character(a_read_character)
+        , wait(a_wait)
+        , new_line_mode_input(a_new_line_mode_input)
+        , new_line_mode_output(a_new_line_mode_output)
+        , table(a_table)
+        , line_buffer_size(0)
+#ifdef CLI_LINE_EDITING
+        , line_cursor(0)
+#endif
+#ifdef CLI_BINARY_CHANNEL
+        , frame_output_id(no_frame)
+#endif
+#ifdef CLI_OUTPUT_BUFFER
+        , output_buffer_size(0)
+#endif
+#ifdef CLI_PERSISTENT_HISTORY
+        , history_loaded(false)
+#endif
+#ifdef CLI_TASKS
+        , type_ahead_size(0)
+        , type_ahead_index(0)
+#endif
+#ifdef CLI_REGISTRY
+        , p_registry(nullptr)
+#endif
+#ifdef CLI_ASSERT
+        , p_sorted_callbacks(nullptr)
+#endif
+#ifdef _WIN32
+        , win32_mode(0)
+#endif
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(nullptr != a_write_character.function);
+        CLI_ASSERT(nullptr != a_write_string.function);
+        CLI_ASSERT(nullptr != a_read_character.function);
+        this->assert_sorted(a_table);
+#endif
+        memset(this->line_buffer, 0x0u, sizeof(line_buffer));
+#ifdef _WIN32
+        GetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), &(this->win32_mode));
+        SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), ENABLE_VIRTUAL_TERMINAL_INPUT | this->win32_mode);
+#endif
+    }
+
+#ifdef _WIN32
+    ~Basic_CLI()
+    {
+        SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), this->win32_mode);
+    }
+#endif
+
+    // works with the table bound at construction
+    Update_status update(Echo a_echo)
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(true == this->is_table_bound());
+#endif
+        return this->update(this->table, a_echo);
+    }
+
+    // a_callbacks comes from make_callbacks_table
+    template<size_t callbacks_count> Update_status update(std::string_view a_prompt,
+                                                          std::string_view a_command_not_found_message,
+                                                          const Callbacks_table<callbacks_count>& a_callbacks,
+                                                          Echo a_echo)
+    {
+        return this->update(Table_view(a_prompt, a_command_not_found_message, a_callbacks), a_echo);
+    }
+
+    Update_status update(const Table_view& a_table, Echo a_echo)
+    {
+        Update_status ret = Update_status::idle;
+
+#ifdef CLI_ASSERT
+        this->assert_sorted(a_table);
+#endif
+#ifdef CLI_TASKS
+        if (true == this->update_task(a_table, &ret))
+        {
+            this->flush();
+            return this->get_update_status(ret);
+        }
+
+        while (false == this->is_task_running() && this->type_ahead_index < this->type_ahead_size)
+        {
+            this->process(this->type_ahead[this->type_ahead_index++], a_table, a_echo, &ret);
+        }
+
+        if (true == this->is_task_running())
+        {
+            this->flush();
+            return this->get_update_status(ret);
+        }
+#endif
+        char c[s::input_buffer_capacity] = { 0 };
+        size_t r                         = 0;
+
+        do
+        {
+            r = this->read_character.function(c, sizeof(c) / sizeof(c[0]), this->read_character.p_user_data);
+
+            if (0 == r && Update_status::idle == ret && nullptr != this->wait.function)
+            {
+                // wait may sleep, whatever the last update left in the output buffer is sent first
+                this->flush();
+                this->wait.function(this->wait.p_user_data);
+                r = this->read_character.function(c, sizeof(c) / sizeof(c[0]), this->read_character.p_user_data);
+            }
+
+            if (0 != r && Update_status::idle == ret)
+            {
+                ret = Update_status::input_consumed;
+            }
+
+            for (size_t char_index = 0; char_index < r; char_index++)
+            {
+#ifdef CLI_TASKS
+                if (true == this->is_task_running())
+                {
+                    this->buffer_type_ahead(c + char_index, r - char_index);
+                    break;
+                }
+#endif
+                this->process(c[char_index], a_table, a_echo, &ret);
+            }
+        } while (s::input_buffer_capacity == r
+#ifdef CLI_TASKS
+                 && false == this->is_task_running()
+#endif
+        );
+
+        this->flush();
+#ifdef CLI_TASKS
+        return this->get_update_status(ret);
+#else
+        return ret;
+#endif
+    }
+
+    Ingest_result ingest()
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(true == this->is_table_bound());
+#endif
+        return this->ingest(this->table);
+    }
+
+    template<size_t callbacks_count> Ingest_result ingest(std::string_view a_prompt,
+                                                          std::string_view a_command_not_found_message,
+                                                          const Callbacks_table<callbacks_count>& a_callbacks)
+    {
+        return this->ingest(Table_view(a_prompt, a_command_not_found_message, a_callbacks));
+    }
+
+    // batch mode for scripted input: every complete line pending in the input is executed without echo and prompt,
+    // tasks started from here run to completion and the lines are kept out of the history
+    Ingest_result ingest(const Table_view& a_table)
+    {
+        Ingest_result ret;
+        Table_view batch_table = a_table;
+
+#ifdef CLI_ASSERT
+        this->assert_sorted(a_table);
+#endif
+        batch_table.prompt = std::string_view();
+#ifdef CLI_TASKS
+        // a task started by update() would be overwritten by the first command of the batch
+        this->run_task_to_completion(batch_table);
+#endif
+
+        char c[s::input_buffer_capacity] = { 0 };
+        size_t r                         = 0;
+
+        while (0 != (r = this->read_character.function(
+                         c, sizeof(c) / sizeof(c[0]), this->read_character.p_user_data)))
+        {
+            ret.bytes_count += r;
+
+            for (size_t char_index = 0; char_index < r; char_index++)
+            {
+#ifdef CLI_BINARY_CHANNEL
+                if (true == this->receive_frame(c[char_index], a_table))
+                {
+#ifdef CLI_TASKS
+                    this->run_task_to_completion(batch_table);
+#endif
+                    continue;
+                }
+#endif
+                if (Key::character != this->escape_parser.feed(c[char_index]))
+                {
+                    continue;
+                }
+
+                switch (c[char_index])
+                {
+                    case '\r':
+                    case '\n': {
+                        if (true == this->is_new_line(c[char_index]))
+                        {
+                            this->line_buffer[this->line_buffer_size] = 0;
+                            this->execute(batch_table, Echo::disabled);
+#ifdef CLI_TASKS
+                            this->run_task_to_completion(batch_table);
+#endif
+                            this->line_buffer_size = 0;
+                            ret.lines_count++;
+                        }
+                    }
+                    break;
+                    case '\b':
+                    case 127u: {
+                        if (this->line_buffer_size > 0)
+                        {
+                            this->line_buffer_size--;
+                        }
+                    }
+                    break;
+                    default: {
+                        if (this->line_buffer_size + 1 < s::line_buffer_capacity &&
+                            true == is_line_character(c[char_index]))
+                        {
+                            this->line_buffer[this->line_buffer_size++] = c[char_index];
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+
+#ifdef CLI_LINE_EDITING
+        this->line_cursor = this->line_buffer_size;
+#endif
+        if (0 != ret.lines_count)
+        {
+            this->write(a_table.prompt);
+        }
+
+        this->flush();
+
+        return ret;
+    }
+
+#ifdef CLI_WRITER
+    // for callbacks: formats into the output of this session, valid as long as the session is
+    Writer get_writer()
+    {
+        return Writer({ write_to_session, this }, this->new_line_mode_output);
+    }
+#endif
+
+#ifdef CLI_REGISTRY
+    // commands of a_p_registry are found after the ones of the table passed to update(), nullptr detaches it
+    void set_registry(Registry_base* a_p_registry)
+    {
+        this->p_registry = a_p_registry;
+    }
+#endif
+
+#ifdef CLI_PERSISTENT_HISTORY
+    // records are read on the first use of the history, not here
+    void set_history_storage(const History_storage& a_storage)
+    {
+#ifdef CLI_ASSERT
+        CLI_ASSERT(nullptr != a_storage.append);
+        CLI_ASSERT(nullptr != a_storage.iterate);
+        CLI_ASSERT(nullptr != a_storage.erase);
+#endif
+        this->history_storage = a_storage;
+        this->history_loaded  = false;
+    }
+#endif
+
+    void flush()
+    {
+#ifdef CLI_OUTPUT_BUFFER
+        if (0 != this->output_buffer_size)
+        {
+            this->write_string.function(std::string_view(this->output_buffer, this->output_buffer_size),
+                                        this->write_string.p_user_data);
+            this->output_buffer_size = 0;
+        }
+#endif
+    }
+
+private:
+    enum class Call_result : uint32_t
+    {
+        done,
+        pending,
+        invalid_arguments,
+        failed,
+        cancelled
+    };
+
+#if defined(CLI_TYPED_PARAMETERS)
+    using Parameter = Argument;
+#elif defined(CLI_COMMAND_PARAMETERS)
+    using Parameter = std::string_view;
+#endif
+
+    enum class Key : uint32_t
+    {
+        character,
+        none,
+        up,
+        down,
+        right,
+        left,
+        home,
+        end,
+        del,
+        word_left,
+        word_right
+    };
+
+#ifndef CML
+    Basic_CLI(const Basic_CLI&) = delete;
+    Basic_CLI()                 = default;
+    Basic_CLI(Basic_CLI&&)      = default;
+
+    Basic_CLI& operator=(Basic_CLI&&) = default;
+    Basic_CLI& operator=(const Basic_CLI&) = delete;
+#endif
+
+    void process(char a_character, const Table_view& a_table, Echo a_echo, Update_status* a_p_status)
+    {
+#ifdef CLI_BINARY_CHANNEL
+        if (true == this->receive_frame(a_character, a_table))
+        {
+            return;
+        }
+#endif
+        const Key key = this->escape_parser.feed(a_character);
+
+#ifdef CLI_HISTORY_SEARCH
+        if (true == this->search.active && Key::none != key &&
+            true == this->feed_search(key, a_character, a_table.prompt))
+        {
+            return;
+        }
+#endif
+        if (Key::character != key)
+        {
+            this->handle_key(key, a_table.prompt);
+            return;
+        }
+
+        switch (a_character)
+        {
+            case '\r':
+            case '\n': {
+                if (true == this->is_new_line(a_character))
+                {
+                    this->line_buffer[this->line_buffer_size] = 0;
+#ifdef CLI_CAROUSEL
+                    // typed lines only - a batch from ingest() would flood the history and wear its storage
+                    if (0 != this->line_buffer_size)
+                    {
+                        this->push_history(std::string_view(this->line_buffer, this->line_buffer_size));
+                    }
+#endif
+                    this->execute(a_table, a_echo);
+                    this->line_buffer_size = 0;
+                    *a_p_status            = Update_status::command_executed;
+#ifdef CLI_LINE_EDITING
+                    this->line_cursor = 0;
+#endif
+                }
+            }
+            break;
+            case '\b':
+            case 127u: {
+#ifdef CLI_LINE_EDITING
+                if (this->line_cursor > 0)
+                {
+                    this->erase_characters(this->line_cursor - 1u, 1u);
+                }
+#else
+                if (this->line_buffer_size > 0)
+                {
+                    this->line_buffer_size--;
+                    this->write("\b \b");
+                }
+#endif
+            }
+            break;
+#ifdef CLI_AUTOCOMPLETION
+            case '\t': {
+#ifdef CLI_LINE_EDITING
+                this->move_cursor(this->line_buffer_size);
+#endif
+                this->autocomplete(a_table.prompt, a_table.p_callbacks, a_table.callbacks_count);
+#ifdef CLI_LINE_EDITING
+                this->line_cursor = this->line_buffer_size;
+#endif
+            }
+            break;
+#endif
+#ifdef CLI_HISTORY_SEARCH
+            case search_key: {
+                this->start_search(a_table.prompt);
+            }
+            break;
+#endif
+            default: {
+                if (this->line_buffer_size + 1 < s::line_buffer_capacity && true == is_line_character(a_character))
+                {
+#ifdef CLI_LINE_EDITING
+                    this->insert_character(a_character, a_echo);
+#else
+                    this->line_buffer[this->line_buffer_size++] = a_character;
+
+                    if (Echo::enabled == a_echo)
+                    {
+                        this->write(a_character);
+                    }
+#endif
+                }
+            }
+            break;
+        }
+    }
+
+#ifdef CLI_ASSERT
+    // find() is a binary search, a table not built with make_callbacks_table misses commands; the last table
+    // checked is remembered, so calls passing the same one over and over scan it once
+    void assert_sorted(const Table_view& a_table)
+    {
+        if (a_table.p_callbacks != this->p_sorted_callbacks)
+        {
+            CLI_ASSERT(true == is_sorted(a_table.p_callbacks, a_table.callbacks_count));
+            this->p_sorted_callbacks = a_table.p_callbacks;
+        }
+    }
+#endif
+
+    // update(Echo) and ingest() work with the table given at construction, with CLI_REGISTRY a registry may stand in
+    bool is_table_bound() const
+    {
+#ifdef CLI_REGISTRY
+        return nullptr != this->table.p_callbacks || nullptr != this->p_registry;
+#else
+        return nullptr != this->table.p_callbacks;
+#endif
+    }
+
+    // the line in line_buffer has to be terminated by the caller
+    void execute(const Table_view& a_table, Echo a_echo)
+    {
+        if (Echo::enabled == a_echo)
+        {
+            this->write_new_line();
+        }
+
+#ifdef CLI_COMMAND_CHAINING
+        this->chain     = Chain();
+        this->chain.end = this->line_buffer_size;
+
+        const Call_result result = this->run_chain(a_table);
+#else
+        const Call_result result = this->run_command(a_table, this->line_buffer, this->line_buffer_size);
+#endif
+
+        if (false == a_table.prompt.empty() && Call_result::pending != result)
+        {
+            this->write(a_table.prompt);
+        }
+    }
+
+    // a single command, tokenized in place; a bad or unknown command is reported here and ends as failed
+    Call_result run_command(const Table_view& a_table, char* a_p_line, size_t a_line_size)
+    {
+        if (0 == a_line_size)
+        {
+            return Call_result::done;
+        }
+
+#ifdef CLI_COMMAND_PARAMETERS
+        std::string_view argv[s::max_parameters_count];
+        size_t argc = 0;
+
+        if (false == tokenize(a_p_line, a_line_size, argv, &argc))
+        {
+            this->write(s::invalid_arguments_message);
+            this->write_new_line();
+
+            return Call_result::failed;
+        }
+
+        // only blanks, e.g. the end of "a ; " - nothing to run, so nothing failed
+        if (0 == argc)
+        {
+            return Call_result::done;
+        }
+
+        if (a_line_size > 1)
+        {
+            size_t depth = 0;
+#ifdef CLI_COMMAND_CHAINING
+            uint32_t runs = 1;
+
+            if (argc > 2 && repeat_command == argv[0] &&
+                nullptr == this->find_command(a_table.p_callbacks, a_table.callbacks_count, argv[0]))
+            {
+                if (false == parse_repeat_count(argv[1], &runs))
+                {
+                    this->write(s::invalid_arguments_message);
+                    this->write_new_line();
+
+                    return Call_result::failed;
+                }
+
+                depth = 2;
+            }
+#endif
+            const Callback* p_callback = this->find_command(a_table.p_callbacks, a_table.callbacks_count, argv[depth]);
+#ifdef CLI_SUBCOMMANDS
+            p_callback = find_subcommand(p_callback, argv, argc, &depth);
+#endif
+
+            if (nullptr != p_callback)
+            {
+#if defined(CLI_COMMAND_CHAINING) && defined(CLI_TASKS)
+                // copied like Task does, a registry command may unregister itself and another one take its slot
+                const Callback callback = *p_callback;
+                Call_result result = 0 != runs ? this->invoke(callback, argv + depth, argc - depth) : Call_result::done;
+
+                // the rest of the runs is stepped by update() like the task itself, so Ctrl-C can stop it
+                if (runs > 1 && (Call_result::done == result || Call_result::pending == result))
+                {
+                    this->chain.repeat_left = runs - 1;
+
+                    if (Call_result::done == result)
+                    {
+                        this->task.function    = callback.function;
+                        this->task.p_user_data = callback.p_user_data;
+
+                        result = this->repeat_task();
+                    }
+                }
+#elif defined(CLI_COMMAND_CHAINING)
+                // copied, a registry command may unregister itself and another one take its slot between the runs
+                const Callback callback = *p_callback;
+                Call_result result      = Call_result::done;
+
+                for (uint32_t i = 0; i < runs && Call_result::done == result; i++)
+                {
+                    result = this->invoke(callback, argv + depth, argc - depth);
+                }
+#else
+                const Call_result result = this->invoke(*p_callback, argv + depth, argc - depth);
+#endif
+
+                if (Call_result::invalid_arguments == result)
+                {
+                    this->write(s::invalid_arguments_message);
+                    this->write_new_line();
+
+                    return Call_result::failed;
+                }
+
+                return result;
+            }
+        }
+#else
+        if (a_line_size > 1)
+        {
+            const Callback* p_callback = this->find_command(
+                a_table.p_callbacks, a_table.callbacks_count, std::string_view(a_p_line, a_line_size));
+
+            if (nullptr != p_callback)
+            {
+                return this->invoke(*p_callback);
+            }
+        }
+#endif
+        this->write(a_table.command_not_found_message);
+        this->write_new_line();
+
+        return Call_result::failed;
+    }
+
+#ifdef CLI_COMMAND_CHAINING
+    // runs the commands of the line from chain.next on; && skips a command when the one before it failed,
+    // ; runs it anyway. Stops early only when a command goes on as a task
+    Call_result run_chain(const Table_view& a_table)
+    {
+        Call_result result = Call_result::done;
+
+        while (this->chain.next < this->chain.end)
+        {
+            const size_t first     = this->chain.next;
+            const bool conditional = this->chain.conditional;
+            const size_t last      = find_separator(
+                this->line_buffer, first, this->chain.end, &(this->chain.next), &(this->chain.conditional));
+
+            if (true == conditional && false == this->chain.succeeded)
+            {
+                continue;
+            }
+
+            result = this->run_command(a_table, this->line_buffer + first, last - first);
+
+            if (Call_result::pending == result)
+            {
+                return result;
+            }
+
+            this->chain.succeeded = Call_result::done == result;
+        }
+
+        return result;
+    }
+
+    // end of the command starting at a_first: the next ; or && outside quotes, or a_last when there is none
+    static size_t
+    find_separator(const char* a_p_line, size_t a_first, size_t a_last, size_t* a_p_next, bool* a_p_conditional)
+    {
+        bool quoted = false;
+
+        for (size_t i = a_first; i < a_last; i++)
+        {
+            if ('\\' == a_p_line[i])
+            {
+                i++;
+            }
+            else if ('"' == a_p_line[i])
+            {
+                quoted = !quoted;
+            }
+            else if (false == quoted && ';' == a_p_line[i])
+            {
+                *a_p_next        = i + 1u;
+                *a_p_conditional = false;
+
+                return i;
+            }
+            else if (false == quoted && '&' == a_p_line[i] && i + 1u < a_last && '&' == a_p_line[i + 1u])
+            {
+                *a_p_next        = i + 2u;
+                *a_p_conditional = true;
+
+                return i;
+            }
+        }
+
+        *a_p_next        = a_last;
+        *a_p_conditional = false;
+
+        return a_last;
+    }
+
+    static bool parse_repeat_count(std::string_view a_token, uint32_t* a_p_count)
+    {
+        uint32_t count = 0;
+
+        for (char c : a_token)
+        {
+            if (c < '0' || c > '9' || count > (0xFFFFFFFFu - static_cast<uint32_t>(c - '0')) / 10u)
+            {
+                return false;
+            }
+
+            count = count * 10u + static_cast<uint32_t>(c - '0');
+        }
+
+        *a_p_count = count;
+
+        return false == a_token.empty();
+    }
+#endif
+
+    // control characters without a meaning of their own (Ctrl-C outside a task, NUL from the console) are dropped
+    static bool is_line_character(char a_character)
+    {
+        return '\t' == a_character || static_cast<uint8_t>(a_character) >= 0x20u;
+    }
+
+    bool is_new_line(char a_character) const
+    {
+        switch (a_character)
+        {
+            case '\r':
+                return New_line_mode_flag::cr == this->new_line_mode_input;
+            case '\n':
+                return New_line_mode_flag::lf == this->new_line_mode_input ||
+                       (static_cast<uint32_t>(this->new_line_mode_input) ==
+                        (static_cast<uint32_t>(New_line_mode_flag::cr) |
+                         static_cast<uint32_t>(New_line_mode_flag::lf)));
+        }
+
+        return false;
+    }
+
+#ifdef CLI_COMMAND_PARAMETERS
+    // splits on runs of spaces and tabs, honours "quoted strings" and backslash escapes (\n, \t, \r, anything else
+    // is taken literally); escapes are resolved in place so the tokens point into a_p_line
+    static bool tokenize(char* a_p_line, size_t a_line_size, std::string_view a_argv[], size_t* a_p_argc)
+    {
+        size_t read  = 0;
+        size_t write = 0;
+
+        *a_p_argc = 0;
+
+        while (true)
+        {
+            while (read < a_line_size && (' ' == a_p_line[read] || '\t' == a_p_line[read]))
+            {
+                read++;
+            }
+
+            if (read == a_line_size)
+            {
+                return true;
+            }
+
+            if (s::max_parameters_count == *a_p_argc)
+            {
+                return false;
+            }
+
+            const size_t first = write;
+            bool quoted        = false;
+
+            while (read < a_line_size && (true == quoted || (' ' != a_p_line[read] && '\t' != a_p_line[read])))
+            {
+                const char c = a_p_line[read++];
+
+                if ('"' == c)
+                {
+                    quoted = !quoted;
+                }
+                else if ('\\' == c && read < a_line_size)
+                {
+                    a_p_line[write++] = unescape(a_p_line[read++]);
+                }
+                else
+                {
+                    a_p_line[write++] = c;
+                }
+            }
+
+            if (true == quoted)
+            {
+                return false;
+            }
+
+            a_argv[(*a_p_argc)++] = std::string_view(a_p_line + first, write - first);
+        }
+    }
+
+    static char unescape(char a_character)
+    {
+        switch (a_character)
+        {
+            case 'n':
+                return '\n';
+            case 't':
+                return '\t';
+            case 'r':
+                return '\r';
+        }
+
+        return a_character;
+    }
+
+    Call_result invoke(const Callback& a_callback, std::string_view a_argv[], size_t a_argc)
+    {
+#if defined(CLI_TASKS)
+        Parameter* p_parameters = this->task.parameters;
+#elif defined(CLI_TYPED_PARAMETERS)
+        Argument parameters[s::max_parameters_count];
+        Argument* p_parameters = parameters;
+#else
+        std::string_view* p_parameters = a_argv;
+#endif
+
+#if defined(CLI_TYPED_PARAMETERS)
+        if (false == parse_arguments(a_callback.signature, a_argv, a_argc, p_parameters))
+        {
+            return Call_result::invalid_arguments;
+        }
+#elif defined(CLI_TASKS)
+        for (size_t i = 0; i < a_argc; i++)
+        {
+            p_parameters[i] = a_argv[i];
+        }
+#endif
+
+#ifdef CLI_TASKS
+        this->task.parameters_count = a_argc;
+        return this->start_task(a_callback);
+#elif defined(CLI_COMMAND_CHAINING)
+        this->flush();
+
+        return Command_status::failed == a_callback.function(p_parameters, a_argc, a_callback.p_user_data)
+                   ? Call_result::failed
+                   : Call_result::done;
+#else
+        this->flush();
+        a_callback.function(p_parameters, a_argc, a_callback.p_user_data);
+
+        return Call_result::done;
+#endif
+    }
+#else
+    Call_result invoke(const Callback& a_callback)
+    {
+#ifdef CLI_TASKS
+        return this->start_task(a_callback);
+#else
+        this->flush();
+        a_callback.function(a_callback.p_user_data);
+
+        return Call_result::done;
+#endif
+    }
+#endif
+
+#ifdef CLI_TASKS
+    bool is_task_running() const
+    {
+        return nullptr != this->task.function;
+    }
+
+    Update_status get_update_status(Update_status a_status) const
+    {
+        if (Update_status::idle == a_status && true == this->is_task_running())
+        {
+            return Update_status::task_running;
+        }
+
+        return a_status;
+    }
+
+    Call_result start_task(const Callback& a_callback)
+    {
+        this->task.function         = a_callback.function;
+        this->task.p_user_data      = a_callback.p_user_data;
+        this->task.context          = Task_context();
+        this->task.cancel_requested = false;
+#ifdef CLI_BINARY_CHANNEL
+        // set while a frame is dispatched
+        this->task.frame_id = this->frame_output_id;
+#endif
+        const Call_result ret = this->step_task();
+
+        if (Call_result::pending != ret)
+        {
+            this->task.function = nullptr;
+        }
+
+        return ret;
+    }
+
+    Call_result step_task()
+    {
+        this->flush();
+#ifdef CLI_BINARY_CHANNEL
+        this->frame_output_id = this->task.frame_id;
+#endif
+#ifdef CLI_COMMAND_PARAMETERS
+        const Command_status status = this->task.function(
+            this->task.parameters, this->task.parameters_count, &(this->task.context), this->task.p_user_data);
+#else
+        const Command_status status = this->task.function(&(this->task.context), this->task.p_user_data);
+#endif
+#ifdef CLI_BINARY_CHANNEL
+        this->frame_output_id = no_frame;
+#endif
+#ifdef CLI_COMMAND_CHAINING
+        if (Command_status::failed == status)
+        {
+            return Call_result::failed;
+        }
+#endif
+        return Command_status::pending == status ? Call_result::pending : Call_result::done;
+    }
+
+    void finish_task(std::string_view a_prompt, Call_result a_result)
+    {
+        this->task.function = nullptr;
+
+#ifdef CLI_BINARY_CHANNEL
+        if (no_frame != this->task.frame_id)
+        {
+            this->write_frame(this->task.frame_id, get_frame_status(a_result));
+            return;
+        }
+#endif
+        if (Call_result::cancelled == a_result)
+        {
+            this->write("^C");
+            this->write_new_line();
+        }
+
+        if (false == a_prompt.empty())
+        {
+            this->write(a_prompt);
+        }
+    }
+
+    // steps the running task once, input read meanwhile is kept as type-ahead, Ctrl-C cancels the task;
+    // no more than the type-ahead can hold is read, the rest (a Ctrl-C too) waits in the source until the task ends
+    bool update_task(const Table_view& a_table, Update_status* a_p_status)
+    {
+        if (false == this->is_task_running())
+        {
+            return false;
+        }
+
+        char c[s::input_buffer_capacity] = { 0 };
+        size_t read_size                 = 0;
+        size_t r                         = 0;
+
+        do
+        {
+            const size_t free_size =
+                s::type_ahead_buffer_capacity - (this->type_ahead_size - this->type_ahead_index);
+
+            read_size = free_size < s::input_buffer_capacity ? free_size : s::input_buffer_capacity;
+            r         = 0 != read_size ?
+                            this->read_character.function(c, read_size, this->read_character.p_user_data) :
+                            0;
+
+            this->buffer_type_ahead(c, r);
+
+            if (0 != r)
+            {
+                *a_p_status = Update_status::input_consumed;
+            }
+        } while (0 != read_size && read_size == r);
+
+        if (true == this->task.cancel_requested)
+        {
+            this->cancel_task(a_table.prompt);
+            *a_p_status = Update_status::command_executed;
+
+            return false;
+        }
+
+        Call_result result = this->step_task();
+#ifdef CLI_COMMAND_CHAINING
+        result = this->continue_chain(a_table, result);
+#endif
+        if (Call_result::pending == result)
+        {
+            return true;
+        }
+
+        this->finish_task(a_table.prompt, result);
+        *a_p_status = Update_status::command_executed;
+
+        return false;
+    }
+
+    void cancel_task(std::string_view a_prompt)
+    {
+        this->task.context.cancelled = true;
+        this->step_task();
+#ifdef CLI_COMMAND_CHAINING
+        // Ctrl-C drops the rest of the line too
+        this->chain = Chain();
+#endif
+        this->finish_task(a_prompt, Call_result::cancelled);
+    }
+
+    void run_task_to_completion(const Table_view& a_table)
+    {
+        Call_result result = Call_result::done;
+
+        while (true == this->is_task_running())
+        {
+            if (true == this->task.cancel_requested)
+            {
+                this->cancel_task(a_table.prompt);
+                return;
+            }
+
+            while (Call_result::pending == (result = this->step_task()))
+                ;
+#ifdef CLI_COMMAND_CHAINING
+            if (Call_result::pending == this->continue_chain(a_table, result))
+            {
+                continue;
+            }
+#endif
+            this->finish_task(a_table.prompt, result);
+        }
+    }
+
+#ifdef CLI_COMMAND_CHAINING
+    // a task of the chain ended with a_result: further runs of its repeat first, then the rest of the line
+    Call_result continue_chain(const Table_view& a_table, Call_result a_result)
+    {
+        if (Call_result::done == a_result && 0 != this->chain.repeat_left)
+        {
+            return this->repeat_task();
+        }
+
+        if (Call_result::pending == a_result)
+        {
+            return a_result;
+        }
+
+        this->task.function     = nullptr;
+        this->chain.repeat_left = 0;
+        this->chain.succeeded   = Call_result::done == a_result;
+
+        if (Call_result::pending == this->run_chain(a_table))
+        {
+            return Call_result::pending;
+        }
+
+        return a_result;
+    }
+
+    // the next run of the repeated task starts on the next step, the same function with the same parameters
+    Call_result repeat_task()
+    {
+        this->chain.repeat_left--;
+        this->task.context = Task_context();
+
+        return Call_result::pending;
+    }
+#endif
+
+    // Ctrl-C is not kept: it requests the cancel of the running task and drops what was typed ahead of it
+    void buffer_type_ahead(const char* a_p_data, size_t a_data_size)
+    {
+        if (0 != this->type_ahead_index)
+        {
+            memmove(this->type_ahead,
+                    this->type_ahead + this->type_ahead_index,
+                    this->type_ahead_size - this->type_ahead_index);
+
+            this->type_ahead_size -= this->type_ahead_index;
+            this->type_ahead_index = 0;
+        }
+
+        for (size_t i = 0; i < a_data_size; i++)
+        {
+            if ('\x03' == a_p_data[i])
+            {
+                this->task.cancel_requested = true;
+                this->type_ahead_size       = 0;
+            }
+            else if (this->type_ahead_size < s::type_ahead_buffer_capacity)
+            {
+                this->type_ahead[this->type_ahead_size++] = a_p_data[i];
+            }
+        }
+    }
+#endif
+
+    static const Callback* find(const Callback* a_p_callbacks, size_t a_callbacks_count, std::string_view a_name)
+    {
+        size_t first = 0;
+        size_t last  = a_callbacks_count;
+
+        while (first < last)
+        {
+            const size_t middle = first + (last - first) / 2;
+            const int result    = a_p_callbacks[middle].name.compare(a_name);
+
+            if (0 == result)
+            {
+                return a_p_callbacks + middle;
+            }
+
+            if (result < 0)
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const Callback* find_command(const Callback* a_p_callbacks, size_t a_callbacks_count, std::string_view a_name) const
+    {
+        const Callback* p_callback = find(a_p_callbacks, a_callbacks_count, a_name);
+#ifdef CLI_REGISTRY
+        if (nullptr == p_callback && nullptr != this->p_registry)
+        {
+            p_callback = this->p_registry->find(a_name);
+        }
+#endif
+        return p_callback;
+    }
+
+#ifdef CLI_SUBCOMMANDS
+    // one token per level, binary search in every child table; argv[*a_p_depth] becomes argv[0] of the callback
+    static const Callback* find_subcommand(const Callback* a_p_callback,
+                                           const std::string_view a_argv[],
+                                           size_t a_argc,
+                                           size_t* a_p_depth)
+    {
+        while (nullptr != a_p_callback && 0 != a_p_callback->children_count && *a_p_depth + 1 < a_argc)
+        {
+            const Callback* p_child =
+                find(a_p_callback->p_children, a_p_callback->children_count, a_argv[*a_p_depth + 1]);
+
+            if (nullptr == p_child)
+            {
+                break;
+            }
+
+            a_p_callback = p_child;
+            (*a_p_depth)++;
+        }
+
+        return nullptr != a_p_callback && nullptr != a_p_callback->function ? a_p_callback : nullptr;
+    }
+#endif
+
+#ifdef CLI_AUTOCOMPLETION
+    void autocomplete(std::string_view a_prompt, const Callback* a_p_callbacks, size_t a_callbacks_count)
+    {
+        const std::string_view line(this->line_buffer, this->line_buffer_size);
+        std::string_view prefix = line;
+#ifdef CLI_COMMAND_CHAINING
+        // only the last command of a chain is completed
+        for (size_t first = 0, next = 0; first < line.length(); first = next)
+        {
+            bool conditional = false;
+
+            if (line.length() != find_separator(this->line_buffer, first, line.length(), &next, &conditional))
+            {
+                prefix = line.substr(next);
+            }
+        }
+
+        while (false == prefix.empty() && ' ' == prefix[0])
+        {
+            prefix.remove_prefix(1);
+        }
+#endif
+#ifdef CLI_REGISTRY
+        // registered commands live at the top level only
+        const Registry_base* p_top_registry = this->p_registry;
+#endif
+
+#ifdef CLI_SUBCOMMANDS
+        // completed tokens select the level, only the last one is completed
+        for (size_t separator = prefix.find_first_of(' '); std::string_view::npos != separator;
+             separator        = prefix.find_first_of(' '))
+        {
+            const Callback* p_group = find(a_p_callbacks, a_callbacks_count, prefix.substr(0, separator));
+#ifdef CLI_REGISTRY
+            if (nullptr == p_group && nullptr != p_top_registry)
+            {
+                p_group = p_top_registry->find(prefix.substr(0, separator));
+            }
+
+            p_top_registry = nullptr;
+#endif
+
+            if (nullptr == p_group || 0 == p_group->children_count)
+            {
+                return;
+            }
+
+            a_p_callbacks     = p_group->p_children;
+            a_callbacks_count = p_group->children_count;
+
+            prefix.remove_prefix(separator);
+
+            while (false == prefix.empty() && ' ' == prefix[0])
+            {
+                prefix.remove_prefix(1);
+            }
+        }
+#else
+        if (std::string_view::npos != prefix.find_first_of(' '))
+        {
+            return;
+        }
+#endif
+
+        const size_t offset = line.length() - prefix.length();
+        const size_t first  = lower_bound(a_p_callbacks, a_callbacks_count, prefix, false);
+        const size_t last   = lower_bound(a_p_callbacks, a_callbacks_count, prefix, true);
+
+        size_t matches_count   = last - first;
+        std::string_view match = first != last ? a_p_callbacks[first].name : std::string_view();
+        size_t common_length   = first != last ? get_common_length(match, a_p_callbacks[last - 1].name) : 0;
+#ifdef CLI_REGISTRY
+        for (size_t i = 0; nullptr != p_top_registry && i < p_top_registry->get_count(); i++)
+        {
+            const std::string_view name = p_top_registry->get(i).name;
+
+            if (true == is_registered_completion(name, prefix, a_p_callbacks, a_callbacks_count))
+            {
+                common_length = 0 == matches_count ? name.length()
+                                                   : get_common_length(match.substr(0, common_length), name);
+                match         = 0 == matches_count ? name : match;
+                matches_count++;
+            }
+        }
+#endif
+
+        if (0 == matches_count)
+        {
+            return;
+        }
+
+        if (offset + common_length >= s::line_buffer_capacity)
+        {
+            common_length = s::line_buffer_capacity - 1 - offset;
+        }
+
+        if (common_length > prefix.length())
+        {
+            this->write(match.substr(prefix.length(), common_length - prefix.length()));
+            memcpy(this->line_buffer + line.length(), match.data() + prefix.length(), common_length - prefix.length());
+            this->line_buffer_size = offset + common_length;
+        }
+        else if (matches_count > 1)
+        {
+            this->write_new_line();
+
+            for (size_t i = first; i < last; i++)
+            {
+                this->write(' ');
+                this->write(a_p_callbacks[i].name);
+            }
+#ifdef CLI_REGISTRY
+            for (size_t i = 0; nullptr != p_top_registry && i < p_top_registry->get_count(); i++)
+            {
+                const std::string_view name = p_top_registry->get(i).name;
+
+                if (true == is_registered_completion(name, prefix, a_p_callbacks, a_callbacks_count))
+                {
+                    this->write(' ');
+                    this->write(name);
+                }
+            }
+#endif
+
+            this->write_new_line();
+            this->write(a_prompt);
+            this->write(line);
+        }
+    }
+
+#ifdef CLI_REGISTRY
+    // a name shadowed by the static table is never dispatched, so it is not offered either
+    static bool is_registered_completion(std::string_view a_name,
+                                         std::string_view a_prefix,
+                                         const Callback* a_p_callbacks,
+                                         size_t a_callbacks_count)
+    {
+        return a_name.substr(0, a_prefix.length()) == a_prefix &&
+               nullptr == find(a_p_callbacks, a_callbacks_count, a_name);
+    }
+#endif
+
+    static size_t get_common_length(std::string_view a_first, std::string_view a_second)
+    {
+        size_t ret = 0;
+
+        while (ret < a_first.length() && ret < a_second.length() && a_first[ret] == a_second[ret])
+        {
+            ret++;
+        }
+
+        return ret;
+    }
+
+    static size_t lower_bound(const Callback* a_p_callbacks,
+                              size_t a_callbacks_count,
+                              std::string_view a_prefix,
+                              bool a_past_prefix)
+    {
+        size_t first = 0;
+        size_t last  = a_callbacks_count;
+
+        while (first < last)
+        {
+            const size_t middle   = first + (last - first) / 2;
+            const int result      = a_p_callbacks[middle].name.substr(0, a_prefix.length()).compare(a_prefix);
+            const bool go_further = true == a_past_prefix ? result <= 0 : result < 0;
+
+            if (true == go_further)
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+
+        return first;
+    }
+#endif
+
+#ifdef CLI_BINARY_CHANNEL
+    bool receive_frame(char a_character, const Table_view& a_table)
+    {
+        switch (this->frame_decoder.feed(static_cast<uint8_t>(a_character)))
+        {
+            case Frame_decoder::Result::character:
+                return false;
+
+            case Frame_decoder::Result::complete: {
+                this->dispatch_frame(this->frame_decoder.get_data(),
+                                     this->frame_decoder.get_size(),
+                                     a_table.p_callbacks,
+                                     a_table.callbacks_count);
+            }
+            break;
+
+            case Frame_decoder::Result::consumed: {
+                // no command has that id - the rest of the frame is not buffered, the reply goes out at its END
+                if (2u == this->frame_decoder.get_size() &&
+                    nullptr == find_frame_callback(
+                                   a_table.p_callbacks, a_table.callbacks_count, read_frame_id(this->frame_decoder.get_data())))
+                {
+                    this->frame_decoder.discard();
+                }
+            }
+            break;
+
+            case Frame_decoder::Result::discarded: {
+                // a full buffer means the frame was too long, anything shorter had an unknown id
+                if (s::frame_buffer_capacity == this->frame_decoder.get_size())
+                {
+                    this->write_frame(0xFFFFu, Frame_status::malformed_frame);
+                }
+                else
+                {
+                    this->write_frame(read_frame_id(this->frame_decoder.get_data()),
+                                      Frame_status::unknown_command);
+                }
+            }
+            break;
+        }
+
+        return true;
+    }
+
+    static uint16_t read_frame_id(const uint8_t* a_p_frame)
+    {
+        return static_cast<uint16_t>(a_p_frame[0] | (a_p_frame[1] << 8u));
+    }
+
+    // frames address the top level only, a group without its own function cannot be called
+    static const Callback* find_frame_callback(const Callback* a_p_callbacks, size_t a_callbacks_count, uint16_t a_id)
+    {
+        for (size_t i = 0; i < a_callbacks_count; i++)
+        {
+            if (a_id == get_frame_id(a_p_callbacks[i].name))
+            {
+#ifdef CLI_SUBCOMMANDS
+                return nullptr != a_p_callbacks[i].function ? a_p_callbacks + i : nullptr;
+#else
+                return a_p_callbacks + i;
+#endif
+            }
+        }
+
+        return nullptr;
+    }
+
+    void dispatch_frame(const uint8_t* a_p_frame,
+                        size_t a_frame_size,
+                        const Callback* a_p_callbacks,
+                        size_t a_callbacks_count)
+    {
+        if (a_frame_size < 3u)
+        {
+            this->write_frame(0xFFFFu, Frame_status::malformed_frame);
+            return;
+        }
+
+        const uint16_t id           = read_frame_id(a_p_frame);
+        const size_t count          = a_p_frame[2];
+        const Callback* p_callback = find_frame_callback(a_p_callbacks, a_callbacks_count, id);
+
+        if (nullptr == p_callback)
+        {
+            this->write_frame(id, Frame_status::unknown_command);
+            return;
+        }
+
+#ifdef CLI_COMMAND_PARAMETERS
+        std::string_view argv[s::max_parameters_count];
+        size_t argc = 0;
+
+        argv[argc++] = p_callback->name;
+#endif
+        size_t offset = 3u;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (offset >= a_frame_size || a_frame_size - offset - 1u < a_p_frame[offset]
+#ifdef CLI_COMMAND_PARAMETERS
+                || s::max_parameters_count == argc
+#endif
+            )
+            {
+                this->write_frame(id, Frame_status::malformed_frame);
+                return;
+            }
+
+#ifdef CLI_COMMAND_PARAMETERS
+            argv[argc++] = std::string_view(reinterpret_cast<const char*>(a_p_frame + offset + 1u), a_p_frame[offset]);
+#endif
+            offset += a_p_frame[offset] + 1u;
+        }
+
+        if (offset != a_frame_size)
+        {
+            this->write_frame(id, Frame_status::malformed_frame);
+            return;
+        }
+
+        this->frame_output_id = id;
+#ifdef CLI_COMMAND_PARAMETERS
+        const Call_result result = this->invoke(*p_callback, argv, argc);
+#else
+        const Call_result result = this->invoke(*p_callback);
+#endif
+        this->frame_output_id = no_frame;
+
+        // a task answers when it ends
+        if (Call_result::pending != result)
+        {
+            this->write_frame(id, get_frame_status(result));
+        }
+    }
+
+    static Frame_status get_frame_status(Call_result a_result)
+    {
+        switch (a_result)
+        {
+            case Call_result::invalid_arguments:
+                return Frame_status::invalid_arguments;
+
+            case Call_result::failed:
+                return Frame_status::failed;
+
+            case Call_result::cancelled:
+                return Frame_status::cancelled;
+
+            case Call_result::done:
+            case Call_result::pending:
+                break;
+        }
+
+        return Frame_status::ok;
+    }
+
+    void write_frame(uint16_t a_id, Frame_status a_status, std::string_view a_text = std::string_view())
+    {
+        const uint8_t header[] = { static_cast<uint8_t>(a_id & 0xFFu),
+                                   static_cast<uint8_t>(a_id >> 8u),
+                                   static_cast<uint8_t>(a_status) };
+
+        // the frame itself is not output of the command
+        const uint16_t output_id = this->frame_output_id;
+        this->frame_output_id = no_frame;
+
+        this->write(static_cast<char>(Frame_decoder::end));
+
+        for (uint8_t byte : header)
+        {
+            this->write_frame_byte(byte);
+        }
+
+        for (char character : a_text)
+        {
+            this->write_frame_byte(static_cast<uint8_t>(character));
+        }
+
+        this->write(static_cast<char>(Frame_decoder::end));
+
+        this->frame_output_id = output_id;
+    }
+
+    void write_frame_byte(uint8_t a_byte)
+    {
+        switch (a_byte)
+        {
+            case Frame_decoder::end: {
+                this->write(static_cast<char>(Frame_decoder::escape));
+                this->write(static_cast<char>(Frame_decoder::escaped_end));
+            }
+            break;
+
+            case Frame_decoder::escape: {
+                this->write(static_cast<char>(Frame_decoder::escape));
+                this->write(static_cast<char>(Frame_decoder::escaped_escape));
+            }
+            break;
+
+            default: {
+                this->write(static_cast<char>(a_byte));
+            }
+            break;
+        }
+    }
+#endif
+
+#ifdef CLI_CAROUSEL
+    void push_history(std::string_view a_line)
+    {
+#ifdef CLI_PERSISTENT_HISTORY
+        this->load_history();
+
+        if (true == this->carousel.push(a_line) && nullptr != this->history_storage.append &&
+            false == this->history_storage.append(a_line, this->history_storage.p_user_data))
+        {
+            // medium is full - start over with what fits in RAM, the new line is already there
+            this->history_storage.erase(this->history_storage.p_user_data);
+
+            for (size_t offset = 0; offset != this->carousel.get_end(); offset = this->carousel.get_end_of(offset))
+            {
+                this->history_storage.append(this->carousel.get(offset), this->history_storage.p_user_data);
+            }
+        }
+#else
+        this->carousel.push(a_line);
+#endif
+    }
+#endif
+
+#ifdef CLI_PERSISTENT_HISTORY
+    void load_history()
+    {
+        if (false == this->history_loaded && nullptr != this->history_storage.iterate)
+        {
+            this->history_loaded = true;
+            this->history_storage.iterate(load_history_record, this, this->history_storage.p_user_data);
+        }
+    }
+
+    // the arena keeps the newest records when the log holds more than fits
+    static void load_history_record(std::string_view a_record, void* a_p_context)
+    {
+        static_cast<Basic_CLI*>(a_p_context)->carousel.push(a_record);
+    }
+#endif
+
+    void handle_key(Key a_key, std::string_view a_prompt)
+    {
+#ifndef CLI_CAROUSEL
+        static_cast<void>(a_prompt);
+#endif
+        switch (a_key)
+        {
+#ifdef CLI_CAROUSEL
+            case Key::up:
+            case Key::down: {
+#ifdef CLI_PERSISTENT_HISTORY
+                this->load_history();
+#endif
+                if (false == this->carousel.is_empty())
+                {
+                    std::string_view line_data =
+                        Key::up == a_key ? this->carousel.get_previus() : this->carousel.get_next();
+
+                    if (false == line_data.empty())
+                    {
+                        this->render_line(a_prompt, line_data);
+
+                        this->line_buffer_size                    = line_data.length();
+                        this->line_buffer[this->line_buffer_size] = 0;
+                        memcpy(this->line_buffer, line_data.data(), this->line_buffer_size);
+#ifdef CLI_LINE_EDITING
+                        this->line_cursor = this->line_buffer_size;
+#endif
+                    }
+                }
+            }
+            break;
+#endif
+#ifdef CLI_LINE_EDITING
+            case Key::left: {
+                if (this->line_cursor > 0)
+                {
+                    this->move_cursor(this->line_cursor - 1u);
+                }
+            }
+            break;
+
+            case Key::right: {
+                if (this->line_cursor < this->line_buffer_size)
+                {
+                    this->move_cursor(this->line_cursor + 1u);
+                }
+            }
+            break;
+
+            case Key::home: {
+                this->move_cursor(0);
+            }
+            break;
+
+            case Key::end: {
+                this->move_cursor(this->line_buffer_size);
+            }
+            break;
+
+            case Key::del: {
+                if (this->line_cursor < this->line_buffer_size)
+                {
+                    this->erase_characters(this->line_cursor, 1u);
+                }
+            }
+            break;
+
+            case Key::word_left: {
+                size_t position = this->line_cursor;
+
+                while (position > 0 && ' ' == this->line_buffer[position - 1u])
+                {
+                    position--;
+                }
+
+                while (position > 0 && ' ' != this->line_buffer[position - 1u])
+                {
+                    position--;
+                }
+
+                this->move_cursor(position);
+            }
+            break;
+
+            case Key::word_right: {
+                size_t position = this->line_cursor;
+
+                while (position < this->line_buffer_size && ' ' == this->line_buffer[position])
+                {
+                    position++;
+                }
+
+                while (position < this->line_buffer_size && ' ' != this->line_buffer[position])
+                {
+                    position++;
+                }
+
+                this->move_cursor(position);
+            }
+            break;
+#endif
+            default: {
+            }
+            break;
+        }
+    }
+
+#ifdef CLI_LINE_EDITING
+    // only the part of the line from the edit point on is sent, the terminal cursor is put back afterwards
+    void insert_character(char a_character, Echo a_echo)
+    {
+        memmove(this->line_buffer + this->line_cursor + 1u,
+                this->line_buffer + this->line_cursor,
+                this->line_buffer_size - this->line_cursor);
+
+        this->line_buffer[this->line_cursor] = a_character;
+        this->line_buffer_size++;
+        this->line_cursor++;
+
+        if (Echo::enabled == a_echo)
+        {
+            this->write(std::string_view(this->line_buffer + this->line_cursor - 1u,
+                                         this->line_buffer_size - this->line_cursor + 1u));
+            this->write_cursor_left(this->line_buffer_size - this->line_cursor);
+        }
+    }
+
+    void erase_characters(size_t a_position, size_t a_count)
+    {
+        this->move_cursor(a_position);
+
+        memmove(this->line_buffer + a_position,
+                this->line_buffer + a_position + a_count,
+                this->line_buffer_size - a_position - a_count);
+        this->line_buffer_size -= a_count;
+
+        this->write(std::string_view(this->line_buffer + a_position, this->line_buffer_size - a_position));
+        this->erase_to_end(a_count, this->line_buffer_size - a_position);
+    }
+
+    void move_cursor(size_t a_position)
+    {
+        if (a_position < this->line_cursor)
+        {
+            this->write_cursor_left(this->line_cursor - a_position);
+        }
+        else if (a_position > this->line_cursor)
+        {
+            const size_t count = a_position - this->line_cursor;
+
+            // the characters themselves move the cursor right, ESC[nC is taken only when it is shorter
+            if (false == s::ansi_terminal || count <= get_cursor_escape_length(count))
+            {
+                this->write(std::string_view(this->line_buffer + this->line_cursor, count));
+            }
+            else
+            {
+                this->write_cursor_escape(count, 'C');
+            }
+        }
+
+        this->line_cursor = a_position;
+    }
+#endif
+
+#ifdef CLI_HISTORY_SEARCH
+    static constexpr char search_key       = 0x12;
+    static constexpr char search_abort_key = 0x07;
+
+    static constexpr std::string_view search_prefix = "(reverse-i-search)`";
+    static constexpr std::string_view search_infix  = "': ";
+
+    void start_search(std::string_view a_prompt)
+    {
+#ifdef CLI_PERSISTENT_HISTORY
+        this->load_history();
+#endif
+        this->search.active         = true;
+        this->search.matched        = false;
+        this->search.pattern_length = 0;
+
+        this->erase_line(a_prompt.length() + this->line_buffer_size);
+        this->write(search_prefix);
+        this->write(search_infix);
+    }
+
+    // true when the character was taken by the search, otherwise the search is left and the character goes on
+    bool feed_search(Key a_key, char a_character, std::string_view a_prompt)
+    {
+        const std::string_view match = this->get_search_match();
+
+        if (Key::character != a_key)
+        {
+            this->stop_search(a_prompt, true);
+            return false;
+        }
+
+        switch (a_character)
+        {
+            case search_key: {
+                // older entry with the same pattern, the scan starts right below the current match
+                if (false == this->search.matched || false == this->find_search_match(this->search.match_offset))
+                {
+                    this->write('\a');
+                    return true;
+                }
+
+                this->write_search_tail(this->search.pattern_length, search_infix.length() + match.length());
+            }
+            break;
+
+            case '\b':
+            case 127u: {
+                // a shorter pattern is still found in the current match, no rescan needed
+                if (0 != this->search.pattern_length)
+                {
+                    this->search.pattern_length--;
+                    this->write_search_tail(this->search.pattern_length, 1u + search_infix.length() + match.length());
+                }
+            }
+            break;
+
+            case search_abort_key: {
+                this->stop_search(a_prompt, false);
+            }
+            break;
+
+            default: {
+                if (static_cast<uint8_t>(a_character) < 0x20u)
+                {
+                    this->stop_search(a_prompt, true);
+                    return false;
+                }
+
+                if (s::search_pattern_capacity == this->search.pattern_length)
+                {
+                    this->write('\a');
+                    return true;
+                }
+
+                const size_t pattern_length = this->search.pattern_length;
+
+                this->search.pattern[this->search.pattern_length++] = a_character;
+
+                // the current match is checked first, so the scan continues where the previous one stopped
+                const size_t end = true == this->search.matched ? this->carousel.get_end_of(this->search.match_offset)
+                                                                : this->carousel.get_end();
+
+                if (false == this->find_search_match(end))
+                {
+                    this->write('\a');
+                }
+
+                this->write_search_tail(pattern_length, search_infix.length() + match.length());
+            }
+            break;
+        }
+
+        return true;
+    }
+
+    bool find_search_match(size_t a_end)
+    {
+        const std::string_view pattern(this->search.pattern, this->search.pattern_length);
+        size_t offset = 0;
+
+        if (true == this->carousel.search(pattern, a_end, &offset))
+        {
+            this->search.match_offset = offset;
+            this->search.matched      = true;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    std::string_view get_search_match() const
+    {
+        return true == this->search.matched ? this->carousel.get(this->search.match_offset) : std::string_view();
+    }
+
+    // cursor stands at the end of the search line, everything from a_pattern_index on is rewritten
+    void write_search_tail(size_t a_pattern_index, size_t a_old_tail_length)
+    {
+        const std::string_view match = this->get_search_match();
+        const size_t tail_length =
+            this->search.pattern_length - a_pattern_index + search_infix.length() + match.length();
+
+        this->write_cursor_left(a_old_tail_length);
+        this->write(std::string_view(this->search.pattern + a_pattern_index,
+                                     this->search.pattern_length - a_pattern_index));
+        this->write(search_infix);
+        this->write(match);
+
+        if (a_old_tail_length > tail_length)
+        {
+            this->erase_to_end(a_old_tail_length - tail_length, 0u);
+        }
+    }
+
+    void stop_search(std::string_view a_prompt, bool a_accept)
+    {
+        const std::string_view match = this->get_search_match();
+
+        this->erase_line(search_prefix.length() + this->search.pattern_length + search_infix.length() + match.length());
+
+        if (true == a_accept && true == this->search.matched)
+        {
+            memcpy(this->line_buffer, match.data(), match.length());
+            this->line_buffer_size                    = match.length();
+            this->line_buffer[this->line_buffer_size] = 0;
+        }
+#ifdef CLI_LINE_EDITING
+        this->line_cursor = this->line_buffer_size;
+#endif
+
+        this->search.active = false;
+
+        this->write(a_prompt);
+        this->write(std::string_view(this->line_buffer, this->line_buffer_size));
+    }
+
+#endif
+
+    void write(char a_character)
+    {
+#ifdef CLI_BINARY_CHANNEL
+        if (no_frame != this->frame_output_id)
+        {
+            this->write(std::string_view(&a_character, 1u));
+            return;
+        }
+#endif
+#ifdef CLI_OUTPUT_BUFFER
+        if (s::output_buffer_capacity == this->output_buffer_size)
+        {
+            this->flush();
+        }
+
+        this->output_buffer[this->output_buffer_size++] = a_character;
+#else
+        this->write_character.function(a_character, this->write_character.p_user_data);
+#endif
+    }
+
+    void write(std::string_view a_string)
+    {
+        if (true == a_string.empty())
+        {
+            return;
+        }
+#ifdef CLI_BINARY_CHANNEL
+        // a command called by a frame writes back in frames, a raw END in its text would cut the host's frame
+        if (no_frame != this->frame_output_id)
+        {
+            this->write_frame(this->frame_output_id, Frame_status::output, a_string);
+            return;
+        }
+#endif
+#ifdef CLI_OUTPUT_BUFFER
+        if (a_string.length() > s::output_buffer_capacity - this->output_buffer_size)
+        {
+            this->flush();
+        }
+
+        if (a_string.length() > s::output_buffer_capacity)
+        {
+            this->write_string.function(a_string, this->write_string.p_user_data);
+        }
+        else
+        {
+            memcpy(this->output_buffer + this->output_buffer_size, a_string.data(), a_string.length());
+            this->output_buffer_size += a_string.length();
+        }
+#else
+        this->write_string.function(a_string, this->write_string.p_user_data);
+#endif
+    }
+
+#ifdef CLI_WRITER
+    static void write_to_session(std::string_view a_string, void* a_p_session)
+    {
+        static_cast<Basic_CLI*>(a_p_session)->write(a_string);
+    }
+#endif
+
+    void write_new_line()
+    {
+        switch (this->new_line_mode_output)
+        {
+            case New_line_mode_flag::cr: {
+                this->write('\r');
+            }
+            break;
+
+            case New_line_mode_flag::lf: {
+                this->write('\n');
+            }
+            break;
+            default: {
+                this->write("\r\n");
+            }
+        }
+    }
+
+    size_t get_cursor() const
+    {
+#ifdef CLI_LINE_EDITING
+        return this->line_cursor;
+#else
+        return this->line_buffer_size;
+#endif
+    }
+
+    // turns the line on the terminal into a_line with the fewest bytes: the common prefix stays, only the rest is
+    // sent and what is left of the old line erased; line_buffer is read, never written
+    void render_line(std::string_view a_prompt, std::string_view a_line)
+    {
+        const std::string_view old_line(this->line_buffer, this->line_buffer_size);
+        const size_t cursor = this->get_cursor();
+        size_t common       = 0;
+
+        while (common < old_line.length() && common < a_line.length() && old_line[common] == a_line[common])
+        {
+            common++;
+        }
+
+        if (cursor < common)
+        {
+            common = cursor;
+        }
+
+        if (false == s::ansi_terminal)
+        {
+            const size_t padding = old_line.length() > a_line.length() ? old_line.length() - a_line.length() : 0;
+
+            // backspacing to a short common prefix and back over the padding can cost more than a full redraw
+            if (2u + 2u * a_prompt.length() + old_line.length() + a_line.length() <
+                cursor - common + a_line.length() - common + 2u * padding)
+            {
+                this->erase_line(a_prompt.length() + old_line.length());
+                this->write(a_prompt);
+                this->write(a_line);
+
+                return;
+            }
+        }
+
+        if (cursor > common)
+        {
+            this->write_cursor_left(cursor - common);
+        }
+
+        this->write(a_line.substr(common));
+
+        if (old_line.length() > a_line.length())
+        {
+            this->erase_to_end(old_line.length() - a_line.length(), 0u);
+        }
+    }
+
+    // clears a_length characters from the cursor on and leaves the cursor a_distance characters left of it,
+    // overwriting with spaces when that is shorter than ESC[K followed by the same move back
+    void erase_to_end(size_t a_length, size_t a_distance)
+    {
+        if (true == s::ansi_terminal &&
+            3u + get_cursor_left_length(a_distance) < a_length + get_cursor_left_length(a_distance + a_length))
+        {
+            this->write("\033[K");
+            this->write_cursor_left(a_distance);
+        }
+        else
+        {
+            this->write_repeated(' ', a_length);
+            this->write_cursor_left(a_distance + a_length);
+        }
+    }
+
+    // the cursor stands at the end of a line a_length characters long, prompt included
+    void erase_line(size_t a_length)
+    {
+        this->write('\r');
+
+        if (true == s::ansi_terminal)
+        {
+            this->write("\033[K");
+        }
+        else
+        {
+            this->write_repeated(' ', a_length);
+            this->write('\r');
+        }
+    }
+
+    void write_cursor_left(size_t a_count)
+    {
+        if (a_count > get_cursor_left_length(a_count))
+        {
+            this->write_cursor_escape(a_count, 'D');
+        }
+        else
+        {
+            this->write_repeated('\b', a_count);
+        }
+    }
+
+    void write_cursor_escape(size_t a_count, char a_direction)
+    {
+        char digits[20];
+        size_t length = 0;
+
+        do
+        {
+            digits[length++] = static_cast<char>('0' + a_count % 10u);
+            a_count /= 10u;
+        } while (0 != a_count);
+
+        this->write("\033[");
+
+        while (length > 0)
+        {
+            this->write(digits[--length]);
+        }
+
+        this->write(a_direction);
+    }
+
+    // bytes written by write_cursor_left(a_count)
+    static size_t get_cursor_left_length(size_t a_count)
+    {
+        if (true == s::ansi_terminal && a_count > get_cursor_escape_length(a_count))
+        {
+            return get_cursor_escape_length(a_count);
+        }
+
+        return a_count;
+    }
+
+    static size_t get_cursor_escape_length(size_t a_count)
+    {
+        size_t ret = 3u;
+
+        do
+        {
+            ret++;
+            a_count /= 10u;
+        } while (0 != a_count);
+
+        return ret;
+    }
+
+    void write_repeated(char a_character, size_t a_count)
+    {
+        char chunk[16];
+        memset(chunk, a_character, sizeof(chunk));
+
+        for (; a_count > sizeof(chunk); a_count -= sizeof(chunk))
+        {
+            this->write(std::string_view(chunk, sizeof(chunk)));
+        }
+
+        this->write(std::string_view(chunk, a_count));
+    }
+
+private:
+    class Escape_parser
+    {
+    public:
+        Escape_parser()
+            : state(State::idle)
+            , parameter(0)
+            , modifier(0)
+        {
+        }
+
+        Key feed(char a_character)
+        {
+            switch (this->state)
+            {
+                case State::idle: {
+                    if ('\033' == a_character)
+                    {
+                        this->state = State::escape;
+                        return Key::none;
+                    }
+                }
+                break;
+
+                case State::escape: {
+                    this->parameter = 0;
+                    this->modifier  = 0;
+                    this->state     = '[' == a_character ? State::csi : ('O' == a_character ? State::ss3 : State::idle);
+
+                    // Alt-b, Alt-f
+                    switch (a_character)
+                    {
+                        case 'b':
+                            return Key::word_left;
+                        case 'f':
+                            return Key::word_right;
+                    }
+
+                    return Key::none;
+                }
+                break;
+
+                case State::csi:
+                case State::csi_modifier: {
+                    if (a_character >= '0' && a_character <= '9')
+                    {
+                        uint32_t* p_value = State::csi == this->state ? &(this->parameter) : &(this->modifier);
+
+                        if (*p_value < 1000u)
+                        {
+                            *p_value = *p_value * 10u + static_cast<uint32_t>(a_character - '0');
+                        }
+
+                        return Key::none;
+                    }
+
+                    // ESC[1;5D - the second parameter carries Shift/Alt/Ctrl
+                    if (';' == a_character)
+                    {
+                        this->state = State::csi_modifier;
+                        return Key::none;
+                    }
+
+                    if (a_character >= 0x20 && a_character <= 0x3F)
+                    {
+                        return Key::none;
+                    }
+
+                    this->state = State::idle;
+
+                    if ('~' == a_character)
+                    {
+                        switch (this->parameter)
+                        {
+                            case 1u:
+                            case 7u:
+                                return Key::home;
+                            case 3u:
+                                return Key::del;
+                            case 4u:
+                            case 8u:
+                                return Key::end;
+                        }
+
+                        return Key::none;
+                    }
+
+                    return decode(a_character, this->modifier);
+                }
+                break;
+
+                case State::ss3: {
+                    this->state = State::idle;
+                    return decode(a_character, 0);
+                }
+                break;
+            }
+
+            return Key::character;
+        }
+
+    private:
+        enum class State : uint32_t
+        {
+            idle,
+            escape,
+            csi,
+            csi_modifier,
+            ss3
+        };
+
+        static Key decode(char a_character, uint32_t a_modifier)
+        {
+            // 3 - Alt, 5 - Ctrl
+            const bool word = 3u == a_modifier || 5u == a_modifier;
+
+            switch (a_character)
+            {
+                case 'A':
+                    return Key::up;
+                case 'B':
+                    return Key::down;
+                case 'C':
+                    return true == word ? Key::word_right : Key::right;
+                case 'D':
+                    return true == word ? Key::word_left : Key::left;
+                case 'H':
+                    return Key::home;
+                case 'F':
+                    return Key::end;
+            }
+
+            return Key::none;
+        }
+
+    private:
+        State state;
+        uint32_t parameter;
+        uint32_t modifier;
+    };
+
+#ifdef CLI_BINARY_CHANNEL
+    static constexpr uint16_t no_frame = 0xFFFFu;
+
+    class Frame_decoder
+    {
+    public:
+        static constexpr uint8_t end            = 0xC0u;
+        static constexpr uint8_t escape         = 0xDBu;
+        static constexpr uint8_t escaped_end    = 0xDCu;
+        static constexpr uint8_t escaped_escape = 0xDDu;
+
+        enum class Result : uint32_t
+        {
+            character,
+            consumed,
+            complete,
+            discarded
+        };
+
+        Frame_decoder()
+            : state(State::text)
+            , escaped(false)
+            , size(0)
+        {
+        }
+
+        // text mode until END shows up - it can't be typed, so frames and human input can share the line
+        Result feed(uint8_t a_byte)
+        {
+            if (State::text == this->state)
+            {
+                if (end == a_byte)
+                {
+                    this->start();
+                    return Result::consumed;
+                }
+
+                return Result::character;
+            }
+
+            // the rest of a rejected frame is dropped, its closing END is where the reply goes out
+            if (State::discard == this->state)
+            {
+                if (end == a_byte)
+                {
+                    this->state = State::text;
+                    return Result::discarded;
+                }
+
+                return Result::consumed;
+            }
+
+            if (end == a_byte)
+            {
+                if (0 == this->size)
+                {
+                    this->start();
+                    return Result::consumed;
+                }
+
+                this->state = State::text;
+
+                if (true == this->escaped)
+                {
+                    this->size = 0;
+                }
+
+                return Result::complete;
+            }
+
+            // a line end right after END means the END was line noise, the byte goes back to the text console
+            if (0 == this->size && false == this->escaped && ('\r' == a_byte || '\n' == a_byte))
+            {
+                this->state = State::text;
+                return Result::character;
+            }
+
+            if (escape == a_byte)
+            {
+                this->escaped = true;
+                return Result::consumed;
+            }
+
+            if (true == this->escaped)
+            {
+                a_byte        = escaped_end == a_byte ? end : (escaped_escape == a_byte ? escape : a_byte);
+                this->escaped = false;
+            }
+
+            // too long for any frame: the rest of it is discarded with a full buffer
+            if (s::frame_buffer_capacity == this->size)
+            {
+                this->discard();
+                return Result::consumed;
+            }
+
+            this->buffer[this->size++] = a_byte;
+
+            return Result::consumed;
+        }
+
+        // drops the bytes up to the next END, get_data() and get_size() keep what was received so far
+        void discard()
+        {
+            this->state = State::discard;
+        }
+
+        const uint8_t* get_data() const
+        {
+            return this->buffer;
+        }
+
+        size_t get_size() const
+        {
+            return this->size;
+        }
+
+    private:
+        enum class State : uint32_t
+        {
+            text,
+            frame,
+            discard
+        };
+
+        void start()
+        {
+            this->state   = State::frame;
+            this->escaped = false;
+            this->size    = 0;
+        }
+
+    private:
+        uint8_t buffer[s::frame_buffer_capacity];
+
+        State state;
+        bool escaped;
+        size_t size;
+    };
+#endif
+
+#ifdef CLI_CAROUSEL
+    // history packed into one arena as | length | bytes | length | entries, oldest first; the length at both ends
+    // makes stepping in either direction O(1), the oldest entries are evicted when a new one doesn't fit
+    class Carousel
+#ifdef CML
+        : private cml::Non_copyable
+#endif
+    {
+    public:
+        Carousel()
+            : read_offset(0)
+            , used(0)
+        {
+        }
+
+        // false when the line is not stored: empty, longer than the line buffer or the arena can hold or the same as
+        // the newest entry; records loaded from the storage come through here as well
+        bool push(std::string_view a_data)
+        {
+            const size_t entry_size = a_data.length() + 2u * sizeof(Length);
+
+            if (true == a_data.empty() || a_data.length() >= s::line_buffer_capacity ||
+                entry_size > s::carousel_arena_capacity ||
+                (false == this->is_empty() && a_data == this->get_entry(this->get_entry_before(this->used))))
+            {
+                this->read_offset = this->used;
+                return false;
+            }
+
+            size_t first = 0;
+
+            while (this->used - first + entry_size > s::carousel_arena_capacity)
+            {
+                first += this->get_entry_size(first);
+            }
+
+            if (0 != first)
+            {
+                memmove(this->buffer, this->buffer + first, this->used - first);
+                this->used -= first;
+            }
+
+            const Length length = static_cast<Length>(a_data.length());
+
+            memcpy(this->buffer + this->used, &length, sizeof(length));
+            memcpy(this->buffer + this->used + sizeof(length), a_data.data(), a_data.length());
+            memcpy(this->buffer + this->used + sizeof(length) + a_data.length(), &length, sizeof(length));
+
+            this->used += entry_size;
+            this->read_offset = this->used;
+
+            return true;
+        }
+
+        std::string_view get_next() const
+        {
+            if (this->used == this->read_offset)
+            {
+                this->read_offset = 0;
+            }
+            else
+            {
+                this->read_offset += this->get_entry_size(this->read_offset);
+
+                if (this->used == this->read_offset)
+                {
+                    this->read_offset = 0;
+                }
+            }
+
+            return this->get_entry(this->read_offset);
+        }
+
+        std::string_view get_previus() const
+        {
+#ifdef CLI_ASSERT
+            CLI_ASSERT(false == this->is_empty());
+#endif
+            if (0 == this->read_offset)
+            {
+                this->read_offset = this->used;
+            }
+
+            this->read_offset = this->get_entry_before(this->read_offset);
+
+            return this->get_entry(this->read_offset);
+        }
+
+        bool is_empty() const
+        {
+            return 0 == this->used;
+        }
+
+#ifdef CLI_HISTORY_SEARCH
+        // newest entry ending at or before a_end that contains a_pattern, the scan goes towards the oldest one
+        bool search(std::string_view a_pattern, size_t a_end, size_t* a_p_offset) const
+        {
+            while (0 != a_end)
+            {
+                a_end = this->get_entry_before(a_end);
+
+                if (std::string_view::npos != this->get_entry(a_end).find(a_pattern))
+                {
+                    *a_p_offset = a_end;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+#endif
+
+#if defined(CLI_HISTORY_SEARCH) || defined(CLI_PERSISTENT_HISTORY)
+        std::string_view get(size_t a_offset) const
+        {
+            return this->get_entry(a_offset);
+        }
+
+        size_t get_end_of(size_t a_offset) const
+        {
+            return a_offset + this->get_entry_size(a_offset);
+        }
+
+        size_t get_end() const
+        {
+            return this->used;
+        }
+#endif
+
+#ifndef CML
+    private:
+        Carousel(const Carousel&) = delete;
+        Carousel(Carousel&&)      = default;
+
+        Carousel& operator=(Carousel&&) = default;
+        Carousel& operator=(const Carousel&) = delete;
+#endif
+
+    private:
+        using Length = typename std::conditional<s::line_buffer_capacity <= 0x100u,
+                                                 uint8_t,
+                                                 typename std::conditional<s::line_buffer_capacity <= 0x10000u,
+                                                                           uint16_t,
+                                                                           uint32_t>::type>::type;
+
+        static_assert(s::carousel_arena_capacity > 2u * sizeof(Length), "carousel_arena_capacity can't hold an entry");
+
+        size_t get_length(size_t a_offset) const
+        {
+            Length ret = 0;
+            memcpy(&ret, this->buffer + a_offset, sizeof(ret));
+
+            return ret;
+        }
+
+        size_t get_entry_size(size_t a_offset) const
+        {
+            return this->get_length(a_offset) + 2u * sizeof(Length);
+        }
+
+        size_t get_entry_before(size_t a_offset) const
+        {
+            return a_offset - this->get_length(a_offset - sizeof(Length)) - 2u * sizeof(Length);
+        }
+
+        std::string_view get_entry(size_t a_offset) const
+        {
+            return std::string_view(this->buffer + a_offset + sizeof(Length), this->get_length(a_offset));
+        }
+
+    private:
+        char buffer[s::carousel_arena_capacity];
+
+        mutable size_t read_offset;
+        size_t used;
     };
 #endif
 
     Write_character_handler write_character;
     Write_string_handler write_string;
     Read_character_handler read_character;
+    Wait_handler wait;
 
     New_line_mode_flag new_line_mode_input;
     New_line_mode_flag new_line_mode_output;
 
+    Table_view table;
+
     char line_buffer[s::line_buffer_capacity];
     size_t line_buffer_size;
+#ifdef CLI_LINE_EDITING
+    size_t line_cursor;
+#endif
+
+    Escape_parser escape_parser;
+
+#ifdef CLI_BINARY_CHANNEL
+    Frame_decoder frame_decoder;
+    // the frame whose command is running, no_frame while the session writes text
+    uint16_t frame_output_id;
+#endif
+
+#ifdef CLI_OUTPUT_BUFFER
+    char output_buffer[s::output_buffer_capacity];
+    size_t output_buffer_size;
+#endif
 
 #ifdef CLI_CAROUSEL
     Carousel carousel;
 #endif
 
-#ifdef _WIN32
-    DWORD win32_mode;
+#ifdef CLI_HISTORY_SEARCH
+    struct Search
+    {
+        char pattern[s::search_pattern_capacity];
+        size_t pattern_length = 0;
+        size_t match_offset   = 0;
+
+        bool matched = false;
+        bool active  = false;
+    };
+
+    Search search;
 #endif
-};
 
-inline constexpr CLI::New_line_mode_flag operator|(CLI::New_line_mode_flag a_f1, CLI::New_line_mode_flag a_f2)
-{
-    return static_cast<CLI::New_line_mode_flag>(static_cast<uint32_t>(a_f1) | static_cast<uint32_t>(a_f2));
-}
+#ifdef CLI_PERSISTENT_HISTORY
+    History_storage history_storage;
+    bool history_loaded;
+#endif
 
-inline constexpr CLI::New_line_mode_flag operator&(CLI::New_line_mode_flag a_f1, CLI::New_line_mode_flag a_f2)
+#ifdef CLI_TASKS
+    struct Task
+    {
+        // copied, the command may be unregistered while it runs
+        Callback::Function function = nullptr;
+        void* p_user_data           = nullptr;
 
-{
-    return static_cast<CLI::New_line_mode_flag>(static_cast<uint32_t>(a_f1) & static_cast<uint32_t>(a_f2));
-}
+        Task_context context;
 
-inline constexpr CLI::New_line_mode_flag operator|=(CLI::New_line_mode_flag& a_f1, CLI::New_line_mode_flag a_f2)
-{
-    a_f1 = a_f1 | a_f2;
-    return a_f1;
-}
+        // set by Ctrl-C read while the task runs, it is cancelled on its next step
+        bool cancel_requested = false;
+
+#ifdef CLI_COMMAND_PARAMETERS
+        Parameter parameters[s::max_parameters_count];
+        size_t parameters_count = 0;
+#endif
+#ifdef CLI_BINARY_CHANNEL
+        // the frame that started the task, it gets the response when the task ends
+        uint16_t frame_id = no_frame;
+#endif
+    };
+
+    Task task;
+
+    char type_ahead[s::type_ahead_buffer_capacity];
+    size_t type_ahead_size;
+    size_t type_ahead_index;
+#endif
+
+#ifdef CLI_REGISTRY
+    Registry_base* p_registry;
+#endif
+
+#ifdef CLI_ASSERT
+    const Callback* p_sorted_callbacks;
+#endif
+
+#ifdef CLI_COMMAND_CHAINING
+    // "a ; b && c": commands of the line not run yet, kept while one of them runs as a task
+    struct Chain
+    {
+        size_t next = 0;
+        size_t end  = 0;
+
+        uint32_t repeat_left = 0;
+
+        bool conditional = false;
+        bool succeeded   = true;
+    };
+
+    static constexpr std::string_view repeat_command = "repeat";
+
+    Chain chain;
+#endif
+
+#ifdef _WIN32
+    DWORD win32_mode;
+#endif
+};
+
+using CLI = Basic_CLI<>;
 
 } // namespace modules
\ No newline at end of file
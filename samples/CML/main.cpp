@@ -26,6 +26,8 @@
 #define CLI_AUTOCOMPLETION
 #define CLI_CAROUSEL
 #define CLI_COMMAND_PARAMETERS
+#define CLI_OUTPUT_BUFFER
+#define CLI_WRITER
 #include <CLI\CLI.hpp>
 
 namespace {
@@ -68,33 +70,39 @@ uint32_t cli_read_character(char* a_p_out, uint32_t a_buffer_size, void* a_p_use
     return p_usart->receive_bytes_polling(a_p_out, a_buffer_size).data_length_in_words;
 }
 
+// bound to the session in main(), callbacks reach it through their user data
+modules::CLI::Writer cli_writer;
+
 #ifdef CLI_COMMAND_PARAMETERS
-void cli_callback_test(std::string_view a_argv[], uint32_t a_argc, void*)
+void cli_callback_test(std::string_view a_argv[], uint32_t a_argc, void* a_p_writer)
 {
+    modules::CLI::Writer* p_writer = static_cast<modules::CLI::Writer*>(a_p_writer);
+
     for (uint32_t i = 0; i < a_argc; i++)
     {
-        printf("%.*s\n", a_argv[i].length(), a_argv[i].data());
+        p_writer->write_unsigned(i, 2u).write(": ").write(a_argv[i]).write_new_line();
     }
 }
 
-void cli_callback_test_reverse(std::string_view a_argv[], uint32_t a_argc, void*)
+void cli_callback_test_reverse(std::string_view a_argv[], uint32_t a_argc, void* a_p_writer)
 {
+    modules::CLI::Writer* p_writer = static_cast<modules::CLI::Writer*>(a_p_writer);
+
     for (uint32_t i = 0; i < a_argc; i++)
     {
-        printf("%.*s\n", a_argv[a_argc - i - 1].length(), a_argv[a_argc - i - 1].data());
+        p_writer->write_unsigned(a_argc - i - 1, 2u).write(": ").write(a_argv[a_argc - i - 1]).write_new_line();
     }
 }
 #else
-void cli_callback_test(void*)
+void cli_callback_test(void* a_p_writer)
 {
-    puts("test\n");
+    static_cast<modules::CLI::Writer*>(a_p_writer)->write("test").write_new_line();
 }
 
-void cli_callback_test_reverse(void*)
+void cli_callback_test_reverse(void* a_p_writer)
 {
-    puts("test_reverse");
+    static_cast<modules::CLI::Writer*>(a_p_writer)->write("test_reverse").write_new_line();
 }
-
 #endif
 
 } // namespace
@@ -145,21 +153,27 @@ int main()
         initialize_syscalls(&iostream);
         setvbuf(stdout, nullptr, _IONBF, 0);
 
-        const std::array<CLI::Callback, 2> callbacks = { CLI::Callback { "test", cli_callback_test, nullptr },
-                                                         CLI::Callback {
-                                                             "test_reverse", cli_callback_test_reverse, nullptr } };
+        // static - the table lands in flash and can be shared by further sessions on other ports
+        static constexpr CLI::Table<2> table = CLI::make_table(
+            "$ ",
+            "> Command not found",
+            std::array<CLI::Callback, 2> { CLI::Callback { "test", cli_callback_test, &cli_writer },
+                                           CLI::Callback { "test_reverse", cli_callback_test_reverse, &cli_writer } });
 
         CLI cli({ cli_write_character, &iostream },
                 { cli_write_string, &iostream },
                 { cli_read_character, &iostream },
                 CLI::New_line_mode_flag::lf,
-                CLI::New_line_mode_flag::lf);
+                CLI::New_line_mode_flag::lf,
+                table);
+
+        cli_writer = cli.get_writer();
 
         printf("$ ");
 
         while (true)
         {
-            cli.update("$ ", "> Command not found", callbacks, CLI::Echo::enabled);
+            cli.update(CLI::Echo::enabled);
         }
 
         return 0;
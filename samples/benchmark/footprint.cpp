@@ -0,0 +1,95 @@
+/*
+ *   Name: footprint.cpp
+ *
+ *   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+ *   Licensed under the MIT license. See LICENSE file in the project root for details.
+ */
+
+// Translation unit measured by footprint.sh, feature macros are passed on the command line.
+
+// std
+#include <cstdio>
+
+#include <CLI/CLI.hpp>
+
+namespace {
+
+using namespace modules;
+
+#if defined(CLI_TASKS) && defined(CLI_TYPED_PARAMETERS)
+CLI::Command_status callback(CLI::Argument[], size_t, CLI::Task_context*, void*)
+{
+    return CLI::Command_status::done;
+}
+#elif defined(CLI_TASKS) && defined(CLI_COMMAND_PARAMETERS)
+CLI::Command_status callback(std::string_view[], size_t, CLI::Task_context*, void*)
+{
+    return CLI::Command_status::done;
+}
+#elif defined(CLI_TASKS)
+CLI::Command_status callback(CLI::Task_context*, void*)
+{
+    return CLI::Command_status::done;
+}
+#elif defined(CLI_COMMAND_CHAINING) && defined(CLI_TYPED_PARAMETERS)
+CLI::Command_status callback(CLI::Argument[], size_t, void*)
+{
+    return CLI::Command_status::done;
+}
+#elif defined(CLI_COMMAND_CHAINING)
+CLI::Command_status callback(std::string_view[], size_t, void*)
+{
+    return CLI::Command_status::done;
+}
+#elif defined(CLI_TYPED_PARAMETERS)
+void callback(CLI::Argument[], size_t, void*) {}
+#elif defined(CLI_COMMAND_PARAMETERS)
+void callback(std::string_view[], size_t, void*) {}
+#else
+void callback(void*) {}
+#endif
+
+#ifdef CLI_TYPED_PARAMETERS
+constexpr CLI::Table<3> table =
+    CLI::make_table("$ ",
+                    "> Command not found",
+                    std::array<CLI::Callback, 3> { CLI::Callback { "test", callback, nullptr, "*" },
+                                                   CLI::Callback { "test_reverse", callback, nullptr, "*" },
+                                                   CLI::Callback { "exit", callback, nullptr, "" } });
+#else
+constexpr CLI::Table<3> table =
+    CLI::make_table("$ ",
+                    "> Command not found",
+                    std::array<CLI::Callback, 3> { CLI::Callback { "test", callback, nullptr },
+                                                   CLI::Callback { "test_reverse", callback, nullptr },
+                                                   CLI::Callback { "exit", callback, nullptr } });
+#endif
+
+} // namespace
+
+#ifdef FOOTPRINT_SIZEOF
+int main()
+{
+    printf("%zu %zu\n", CLI::get_ram_footprint(), sizeof(table));
+    return 0;
+}
+#else
+void footprint(CLI* a_p_cli)
+{
+    a_p_cli->update(table, CLI::Echo::enabled);
+}
+
+#ifdef CLI_INPUT_RING
+CLI::Input_ring<64u> input_ring;
+
+void footprint_input_ring(char a_character)
+{
+    input_ring.push(a_character);
+}
+
+size_t footprint_input_ring(char* a_p_buffer, size_t a_buffer_size)
+{
+    return CLI::Input_ring<64u>::read_character(a_p_buffer, a_buffer_size, &input_ring);
+}
+#endif
+#endif
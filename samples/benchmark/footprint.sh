@@ -0,0 +1,82 @@
+#!/bin/sh
+#
+#   Name: footprint.sh
+#
+#   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+#   Licensed under the MIT license. See LICENSE file in the project root for details.
+#
+# Prints the RAM of one session (CLI::get_ram_footprint()), the flash taken by the shared command table
+# and the code size of update() per feature macro (or per combination, see FEATURES below); N consoles cost
+# N sessions but one table:
+#     footprint.sh <directory containing CLI> [compiler] [size tool] [extra compiler flags]
+# e.g. footprint.sh ../../.. arm-none-eabi-g++ arm-none-eabi-size "-mcpu=cortex-m0 -mthumb"
+
+set -e
+
+INCLUDE_DIRECTORY=${1:?usage: footprint.sh <directory containing CLI> [compiler] [size tool] [extra flags]}
+CXX=${2:-g++}
+SIZE=${3:-size}
+EXTRA_FLAGS=${4:-}
+
+SOURCE=$(dirname "$0")/footprint.cpp
+OUTPUT=$(mktemp -d)
+trap 'rm -rf "$OUTPUT"' EXIT
+
+# by default every feature is measured on its own, then all of them together; a FEATURES list in the environment
+# measures every combination of it instead - each feature doubles the number of builds, keep such a list short
+# and leave out macros implied by others (CLI_COMMAND_PARAMETERS, CLI_CAROUSEL)
+if [ -n "${FEATURES:-}" ]; then
+    ALL_COMBINATIONS=1
+else
+    ALL_COMBINATIONS=0
+    FEATURES="CLI_AUTOCOMPLETION CLI_CAROUSEL CLI_COMMAND_PARAMETERS CLI_TYPED_PARAMETERS CLI_OUTPUT_BUFFER \
+              CLI_INPUT_RING CLI_BINARY_CHANNEL CLI_TASKS CLI_LINE_EDITING CLI_HISTORY_SEARCH CLI_PERSISTENT_HISTORY \
+              CLI_SUBCOMMANDS CLI_REGISTRY CLI_WRITER CLI_COMMAND_CHAINING"
+fi
+FEATURES_COUNT=$(echo $FEATURES | wc -w)
+
+measure() {
+    DEFINES=""
+    NAMES=""
+    BIT=0
+
+    for FEATURE in $FEATURES; do
+        if [ $((($1 >> BIT) & 1)) -eq 1 ]; then
+            DEFINES="$DEFINES -D$FEATURE"
+            NAMES="$NAMES ${FEATURE%%=*}"
+        fi
+        BIT=$((BIT + 1))
+    done
+
+    $CXX -std=c++17 -Os $EXTRA_FLAGS -I"$INCLUDE_DIRECTORY" $DEFINES -c "$SOURCE" -o "$OUTPUT/footprint.o"
+    TEXT=$($SIZE "$OUTPUT/footprint.o" | awk 'NR == 2 { print $1 }')
+
+    # sizeof is taken from a host build, pass the target ABI in the extra flags when cross compiling
+    if g++ -std=c++17 -I"$INCLUDE_DIRECTORY" $DEFINES -DFOOTPRINT_SIZEOF "$SOURCE" -o "$OUTPUT/footprint" 2>/dev/null; then
+        SIZEOF=$("$OUTPUT/footprint")
+    else
+        SIZEOF="- -"
+    fi
+
+    printf '%-90s %8s %8s %8s\n' "${NAMES:- (none)}" ${SIZEOF} "$TEXT"
+}
+
+printf '%-90s %8s %8s %8s\n' "features" "session" "table" ".text"
+
+if [ $ALL_COMBINATIONS -eq 1 ]; then
+    MASK=0
+    while [ $MASK -lt $((1 << FEATURES_COUNT)) ]; do
+        measure $MASK
+        MASK=$((MASK + 1))
+    done
+else
+    measure 0
+
+    INDEX=0
+    while [ $INDEX -lt $FEATURES_COUNT ]; do
+        measure $((1 << INDEX))
+        INDEX=$((INDEX + 1))
+    done
+
+    measure $(((1 << FEATURES_COUNT) - 1))
+fi
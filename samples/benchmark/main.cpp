@@ -0,0 +1,221 @@
+/*
+ *   Name: main.cpp
+ *
+ *   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+ *   Licensed under the MIT license. See LICENSE file in the project root for details.
+ */
+
+// Host microbenchmark of update() with in-memory handlers:
+//     g++ -std=c++17 -O2 -I<directory containing CLI> main.cpp -o benchmark
+// Add -DCLI_OUTPUT_BUFFER to measure with the output staging buffer.
+
+// std
+#include <chrono>
+#include <cstdio>
+
+#define CLI_AUTOCOMPLETION
+#define CLI_CAROUSEL
+#define CLI_COMMAND_PARAMETERS
+#include <CLI/CLI.hpp>
+
+namespace {
+
+using namespace modules;
+using Clock = std::chrono::steady_clock;
+
+struct Mock
+{
+    std::string_view input;
+
+    size_t read_calls  = 0;
+    size_t write_calls = 0;
+    size_t write_bytes = 0;
+
+    void reset()
+    {
+        this->read_calls  = 0;
+        this->write_calls = 0;
+        this->write_bytes = 0;
+    }
+};
+
+void mock_write_character(char, void* a_p_user_data)
+{
+    Mock* p_mock = static_cast<Mock*>(a_p_user_data);
+
+    p_mock->write_calls++;
+    p_mock->write_bytes++;
+}
+
+void mock_write_string(std::string_view a_string, void* a_p_user_data)
+{
+    Mock* p_mock = static_cast<Mock*>(a_p_user_data);
+
+    p_mock->write_calls++;
+    p_mock->write_bytes += a_string.length();
+}
+
+size_t mock_read_character(char* a_p_buffer, size_t a_buffer_size, void* a_p_user_data)
+{
+    Mock* p_mock = static_cast<Mock*>(a_p_user_data);
+    p_mock->read_calls++;
+
+    const size_t r = a_buffer_size < p_mock->input.length() ? a_buffer_size : p_mock->input.length();
+
+    memcpy(a_p_buffer, p_mock->input.data(), r);
+    p_mock->input.remove_prefix(r);
+
+    return r;
+}
+
+size_t callback_calls = 0;
+
+void callback(std::string_view[], size_t, void*)
+{
+    callback_calls++;
+}
+
+template<size_t count> struct Names
+{
+    static constexpr size_t name_length = 7u;
+
+    char buffer[count][name_length + 1] = {};
+
+    constexpr Names()
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            // reversed order, make_callbacks_table has to do the sorting
+            size_t n = count - 1 - i;
+
+            this->buffer[i][0] = 'c';
+            this->buffer[i][1] = 'm';
+            this->buffer[i][2] = 'd';
+
+            for (size_t d = name_length; d > 3; d--)
+            {
+                this->buffer[i][d - 1] = static_cast<char>('0' + n % 10);
+                n /= 10;
+            }
+        }
+    }
+};
+
+template<size_t count> constexpr Names<count> names;
+
+template<size_t count> constexpr CLI::Callbacks_table<count> make_table()
+{
+    std::array<CLI::Callback, count> ret = {};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ret[i] = CLI::Callback { std::string_view(names<count>.buffer[i], Names<count>::name_length), callback, nullptr };
+    }
+
+    return CLI::make_callbacks_table(ret);
+}
+
+template<size_t count> constexpr CLI::Callbacks_table<count> table = make_table<count>();
+
+void report(const char* a_p_name, size_t a_count, double a_ns, const Mock& a_mock)
+{
+    printf("    %-10s %10.1f ns/op %8.2f writes/op %8.2f bytes/op\n",
+           a_p_name,
+           a_ns / static_cast<double>(a_count),
+           static_cast<double>(a_mock.write_calls) / static_cast<double>(a_count),
+           static_cast<double>(a_mock.write_bytes) / static_cast<double>(a_count));
+}
+
+template<size_t count> void run(size_t a_iterations)
+{
+    Mock mock;
+    CLI cli({ mock_write_character, &mock },
+            { mock_write_string, &mock },
+            { mock_read_character, &mock },
+            CLI::New_line_mode_flag::lf,
+            CLI::New_line_mode_flag::lf);
+
+    printf("%zu commands:\n", count);
+
+    // keystroke: one character typed and erased per update() call
+    {
+        mock.reset();
+        const Clock::time_point start = Clock::now();
+
+        for (size_t i = 0; i < a_iterations; i++)
+        {
+            mock.input = 0 == (i & 1u) ? "a" : "\b";
+            cli.update("$ ", "> Command not found", table<count>, CLI::Echo::enabled);
+        }
+
+        report("keystroke", a_iterations, std::chrono::duration<double, std::nano>(Clock::now() - start).count(), mock);
+    }
+
+    // command: a whole line dispatched per update() call
+    {
+        const std::string_view line = table<count>[count / 2].name;
+        char buffer[Names<count>::name_length + 1];
+
+        memcpy(buffer, line.data(), line.length());
+        buffer[line.length()] = '\n';
+
+        mock.reset();
+        callback_calls                = 0;
+        const Clock::time_point start = Clock::now();
+
+        for (size_t i = 0; i < a_iterations; i++)
+        {
+            mock.input = std::string_view(buffer, sizeof(buffer));
+            cli.update("$ ", "> Command not found", table<count>, CLI::Echo::enabled);
+        }
+
+        report("command", a_iterations, std::chrono::duration<double, std::nano>(Clock::now() - start).count(), mock);
+
+        if (a_iterations != callback_calls)
+        {
+            printf("    command dispatch failed (%zu of %zu)\n", callback_calls, a_iterations);
+        }
+    }
+
+    // tab: only the update() call with '\t' is timed, the prefix matches up to 100 names
+    {
+        double ns = 0;
+        Mock tab_mock;
+
+        for (size_t i = 0; i < a_iterations; i++)
+        {
+            mock.input = "cmd00";
+            cli.update("$ ", "> Command not found", table<count>, CLI::Echo::enabled);
+
+            mock.reset();
+            mock.input                    = "\t";
+            const Clock::time_point start = Clock::now();
+
+            cli.update("$ ", "> Command not found", table<count>, CLI::Echo::enabled);
+
+            ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            tab_mock.write_calls += mock.write_calls;
+            tab_mock.write_bytes += mock.write_bytes;
+
+            mock.input = "\b\b\b\b\b\b\b\b\b\b";
+            cli.update("$ ", "> Command not found", table<count>, CLI::Echo::enabled);
+        }
+
+        report("tab", a_iterations, ns, tab_mock);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    static constexpr size_t iterations = 100000u;
+
+    printf("sizeof(CLI): %zu bytes\n", sizeof(CLI));
+
+    run<10>(iterations);
+    run<100>(iterations);
+    run<1000>(iterations / 10u);
+
+    return 0;
+}
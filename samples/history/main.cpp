@@ -0,0 +1,243 @@
+/*
+ *   Name: main.cpp
+ *
+ *   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+ *   Licensed under the MIT license. See LICENSE file in the project root for details.
+ */
+
+// Persistent history on a RAM simulated NOR flash, survives a "reset" and a torn write; exits with 1 when it does not:
+//     g++ -std=c++17 -I<directory containing CLI> main.cpp -o history
+
+// std
+#include <cstdio>
+
+#define CLI_PERSISTENT_HISTORY
+#include <CLI/CLI.hpp>
+
+namespace {
+
+using namespace modules;
+
+// programming only clears bits, erase sets the whole sector back to 0xFF;
+// record: length | bytes | commit marker, the marker is programmed last so a torn record is recognizable
+class Ram_flash
+{
+public:
+    static constexpr size_t capacity = 64u;
+
+    Ram_flash()
+        : erase_count(0)
+        , tear_next(false)
+    {
+        memset(this->memory, 0xFF, sizeof(this->memory));
+    }
+
+    bool append(std::string_view a_record)
+    {
+        const size_t offset = this->get_end();
+        const size_t size   = a_record.length() + 2u;
+
+        if (a_record.length() >= 0xFFu || offset + size > capacity)
+        {
+            return false;
+        }
+
+        this->program(offset, static_cast<uint8_t>(a_record.length()));
+
+        for (size_t i = 0; i < a_record.length(); i++)
+        {
+            this->program(offset + 1u + i, static_cast<uint8_t>(a_record[i]));
+        }
+
+        if (false == this->tear_next)
+        {
+            this->program(offset + size - 1u, commit);
+        }
+
+        this->tear_next = false;
+
+        return true;
+    }
+
+    void iterate(CLI::History_storage::Record_function a_record, void* a_p_context) const
+    {
+        for (size_t offset = 0; offset < capacity && 0xFFu != this->memory[offset];
+             offset += this->memory[offset] + 2u)
+        {
+            if (commit == this->memory[offset + this->memory[offset] + 1u])
+            {
+                a_record(std::string_view(reinterpret_cast<const char*>(this->memory + offset + 1u),
+                                          this->memory[offset]),
+                         a_p_context);
+            }
+        }
+    }
+
+    void erase()
+    {
+        memset(this->memory, 0xFF, sizeof(this->memory));
+        this->erase_count++;
+    }
+
+    // simulates power loss in the middle of the next append
+    void tear_next_append()
+    {
+        this->tear_next = true;
+    }
+
+    size_t get_erase_count() const
+    {
+        return this->erase_count;
+    }
+
+private:
+    static constexpr uint8_t commit = 0x00u;
+
+    void program(size_t a_offset, uint8_t a_value)
+    {
+        this->memory[a_offset] &= a_value;
+    }
+
+    size_t get_end() const
+    {
+        size_t offset = 0;
+
+        while (offset < capacity && 0xFFu != this->memory[offset])
+        {
+            offset += this->memory[offset] + 2u;
+        }
+
+        return offset;
+    }
+
+private:
+    uint8_t memory[capacity];
+    size_t erase_count;
+    bool tear_next;
+};
+
+bool flash_append(std::string_view a_record, void* a_p_flash)
+{
+    return static_cast<Ram_flash*>(a_p_flash)->append(a_record);
+}
+
+void flash_iterate(CLI::History_storage::Record_function a_record, void* a_p_context, void* a_p_flash)
+{
+    static_cast<Ram_flash*>(a_p_flash)->iterate(a_record, a_p_context);
+}
+
+void flash_erase(void* a_p_flash)
+{
+    static_cast<Ram_flash*>(a_p_flash)->erase();
+}
+
+std::string_view input;
+
+void cli_write_character(char a_character, void*)
+{
+    putchar('\r' == a_character ? '|' : a_character);
+}
+
+void cli_write_string(std::string_view a_string, void*)
+{
+    for (char c : a_string)
+    {
+        cli_write_character(c, nullptr);
+    }
+}
+
+size_t cli_read_character(char* a_p_out, size_t a_buffer_size, void*)
+{
+    const size_t ret = a_buffer_size < input.length() ? a_buffer_size : input.length();
+
+    memcpy(a_p_out, input.data(), ret);
+    input.remove_prefix(ret);
+
+    return ret;
+}
+
+// name of the last command the session ran, the checks in main compare it with what the history recalled
+std::string_view executed;
+
+void cli_callback(void* a_p_name)
+{
+    executed = static_cast<const char*>(a_p_name);
+}
+
+// the log has to hold at least what the arena does, otherwise rewriting it after an erase fills it up again
+struct History_traits : CLI_traits
+{
+    static constexpr size_t carousel_arena_capacity = 32u;
+};
+
+static_assert(History_traits::carousel_arena_capacity <= Ram_flash::capacity);
+
+constexpr CLI::Table<3> table =
+    CLI::make_table("$ ",
+                    "> Command not found",
+                    std::array<CLI::Callback, 3> {
+                        CLI::Callback { "led_on", cli_callback, const_cast<char*>("led_on") },
+                        CLI::Callback { "led_off", cli_callback, const_cast<char*>("led_off") },
+                        CLI::Callback { "reboot", cli_callback, const_cast<char*>("reboot") } });
+
+// returns the last command executed
+std::string_view session(Ram_flash* a_p_flash, std::string_view a_input)
+{
+    Basic_CLI<History_traits> cli({ cli_write_character, nullptr },
+                                  { cli_write_string, nullptr },
+                                  { cli_read_character, nullptr },
+                                  CLI::New_line_mode_flag::lf,
+                                  CLI::New_line_mode_flag::lf,
+                                  table);
+
+    cli.set_history_storage({ flash_append, flash_iterate, flash_erase, a_p_flash });
+
+    input    = a_input;
+    executed = std::string_view();
+
+    while (false == input.empty())
+    {
+        cli.update(CLI::Echo::enabled);
+    }
+
+    printf("\n");
+
+    return executed;
+}
+
+bool expect(bool a_condition, const char* a_p_description)
+{
+    if (false == a_condition)
+    {
+        printf("FAILED: %s\n", a_p_description);
+    }
+
+    return a_condition;
+}
+
+} // namespace
+
+int main()
+{
+    Ram_flash flash;
+    bool passed = true;
+
+    passed = expect("led_off" == session(&flash, "led_on\nled_off\n"), "first session runs led_off last") && passed;
+
+    // the reset comes while "reboot" is being written, it must not show up afterwards
+    flash.tear_next_append();
+    passed = expect("reboot" == session(&flash, "reboot\n"), "reboot runs before the torn write") && passed;
+
+    // up twice recalls led_on from the previous session
+    passed = expect("led_on" == session(&flash, "\x1b[A\x1b[A\n"), "up twice recalls led_on") && passed;
+
+    // enough lines to fill the sector, it is erased and rewritten with what the arena holds
+    session(&flash, "led_off\nled_on\nled_off\nled_on\nled_off\nled_on\n");
+    printf("erase count: %zu\n", flash.get_erase_count());
+    passed = expect(1u == flash.get_erase_count(), "the full sector is erased once") && passed;
+
+    // the rewritten log alternates, reboot from the torn write is gone
+    passed = expect("led_on" == session(&flash, "\x1b[A\x1b[A\x1b[A\n"), "up three times recalls led_on") && passed;
+
+    return true == passed ? 0 : 1;
+}
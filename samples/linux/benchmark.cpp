@@ -0,0 +1,248 @@
+/*
+ *   Name: benchmark.cpp
+ *
+ *   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+ *   Licensed under the MIT license. See LICENSE file in the project root for details.
+ */
+
+// Drives the linux sample through a pseudo-terminal, usable headless (CI):
+//     g++ -std=c++17 -O2 -I<directory containing CLI> main.cpp -o sample
+//     g++ -std=c++17 -O2 benchmark.cpp -o benchmark
+//     ./benchmark ./sample [keystrokes count] [commands count]
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// posix
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Terminal
+{
+    int master          = -1;
+    pid_t child         = -1;
+    uint64_t bytes_read = 0;
+};
+
+bool spawn(Terminal* a_p_terminal, const char* a_p_path)
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || 0 != grantpt(master) || 0 != unlockpt(master))
+    {
+        return false;
+    }
+
+    const char* p_slave_name = ptsname(master);
+    const pid_t child        = fork();
+
+    if (0 == child)
+    {
+        setsid();
+
+        const int slave = open(p_slave_name, O_RDWR);
+
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        close(slave);
+        close(master);
+
+        execl(a_p_path, a_p_path, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    a_p_terminal->master = master;
+    a_p_terminal->child  = child;
+
+    return child > 0;
+}
+
+void send(Terminal* a_p_terminal, std::string_view a_data)
+{
+    while (false == a_data.empty())
+    {
+        const ssize_t w = write(a_p_terminal->master, a_data.data(), a_data.length());
+
+        if (w <= 0)
+        {
+            return;
+        }
+
+        a_data.remove_prefix(static_cast<size_t>(w));
+    }
+}
+
+// reads until a_pattern shows up in the output, returns false on timeout
+bool expect(Terminal* a_p_terminal, std::string_view a_pattern, int a_timeout_ms = 5000)
+{
+    size_t matched = 0;
+    char c[256];
+
+    while (true)
+    {
+        pollfd fd = { a_p_terminal->master, POLLIN, 0 };
+
+        if (1 != poll(&fd, 1u, a_timeout_ms))
+        {
+            return false;
+        }
+
+        // one byte at a time, nothing past the pattern may be consumed
+        const ssize_t r = read(a_p_terminal->master, c, 1u);
+
+        if (r <= 0)
+        {
+            return false;
+        }
+
+        a_p_terminal->bytes_read++;
+
+        if (c[0] == a_pattern[matched])
+        {
+            matched++;
+        }
+        else
+        {
+            matched = c[0] == a_pattern[0] ? 1u : 0u;
+        }
+
+        if (a_pattern.length() == matched)
+        {
+            return true;
+        }
+    }
+}
+
+double percentile(const std::vector<double>& a_sorted, double a_p)
+{
+    const size_t index = static_cast<size_t>(a_p * static_cast<double>(a_sorted.size() - 1));
+    return a_sorted[index];
+}
+
+void measure_echo_latency(Terminal* a_p_terminal, size_t a_keystrokes_count)
+{
+    std::vector<double> latencies_us;
+    latencies_us.reserve(a_keystrokes_count);
+
+    for (size_t i = 0; i < a_keystrokes_count; i++)
+    {
+        const Clock::time_point start = Clock::now();
+
+        send(a_p_terminal, "a");
+
+        if (false == expect(a_p_terminal, "a"))
+        {
+            puts("echo: timeout");
+            return;
+        }
+
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        send(a_p_terminal, "\b");
+        expect(a_p_terminal, "\b \b");
+    }
+
+    if (true == latencies_us.empty())
+    {
+        return;
+    }
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+
+    printf("echo latency [us]: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f (%zu keystrokes)\n",
+           percentile(latencies_us, 0.5),
+           percentile(latencies_us, 0.9),
+           percentile(latencies_us, 0.99),
+           latencies_us.back(),
+           latencies_us.size());
+}
+
+void measure_commands(Terminal* a_p_terminal, size_t a_commands_count)
+{
+    static constexpr std::string_view command = "test_reverse 0x08000000 16\r";
+
+    const uint64_t bytes_read_start = a_p_terminal->bytes_read;
+    const Clock::time_point start   = Clock::now();
+
+    // the pty buffer is small, keep only a window of commands in flight
+    static constexpr size_t window = 16u;
+
+    size_t sent     = 0;
+    size_t received = 0;
+
+    while (received < a_commands_count)
+    {
+        while (sent < a_commands_count && sent - received < window)
+        {
+            send(a_p_terminal, command);
+            sent++;
+        }
+
+        if (false == expect(a_p_terminal, "$ "))
+        {
+            puts("commands: timeout");
+            return;
+        }
+
+        received++;
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("commands: %.0f commands/s, %.1f bytes written per command (%zu commands)\n",
+           static_cast<double>(a_commands_count) / seconds,
+           static_cast<double>(a_p_terminal->bytes_read - bytes_read_start) / static_cast<double>(a_commands_count),
+           a_commands_count);
+}
+
+} // namespace
+
+int main(int a_argc, char* a_p_argv[])
+{
+    if (a_argc < 2)
+    {
+        fprintf(stderr, "usage: %s <path to linux sample> [keystrokes count] [commands count]\n", a_p_argv[0]);
+        return 1;
+    }
+
+    const size_t keystrokes_count = a_argc > 2 ? strtoul(a_p_argv[2], nullptr, 10) : 1000u;
+    const size_t commands_count   = a_argc > 3 ? strtoul(a_p_argv[3], nullptr, 10) : 1000u;
+
+    Terminal terminal;
+
+    if (false == spawn(&terminal, a_p_argv[1]) || false == expect(&terminal, "$ "))
+    {
+        fprintf(stderr, "cannot start %s\n", a_p_argv[1]);
+        return 1;
+    }
+
+    measure_echo_latency(&terminal, keystrokes_count);
+    measure_commands(&terminal, commands_count);
+
+    send(&terminal, "exit\r");
+
+    int status = 0;
+    if (terminal.child != waitpid(terminal.child, &status, 0))
+    {
+        kill(terminal.child, SIGKILL);
+    }
+
+    close(terminal.master);
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+ *   Name: main.cpp
+ *
+ *   Copyright (c) Mateusz Semegen and contributors. All rights reserved.
+ *   Licensed under the MIT license. See LICENSE file in the project root for details.
+ */
+
+// std
+#include <assert.h>
+#include <stdlib.h>
+
+// posix
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define CLI_ASSERT assert
+#define CLI_AUTOCOMPLETION
+#define CLI_CAROUSEL
+#define CLI_COMMAND_CHAINING
+#define CLI_COMMAND_PARAMETERS
+#define CLI_HISTORY_SEARCH
+#define CLI_LINE_EDITING
+#define CLI_PERSISTENT_HISTORY
+#define CLI_SUBCOMMANDS
+#define CLI_OUTPUT_BUFFER
+#include <CLI/CLI.hpp>
+
+namespace {
+
+class Raw_mode
+{
+public:
+    Raw_mode()
+        : active(false)
+    {
+        if (1 == isatty(STDIN_FILENO) && 0 == tcgetattr(STDIN_FILENO, &(this->original)))
+        {
+            termios raw = this->original;
+
+            raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+            raw.c_oflag &= ~(OPOST);
+            raw.c_cflag |= CS8;
+            raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+
+            raw.c_cc[VMIN]  = 0;
+            raw.c_cc[VTIME] = 0;
+
+            this->active = 0 == tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+        }
+    }
+
+    ~Raw_mode()
+    {
+        this->restore();
+    }
+
+    void restore()
+    {
+        if (true == this->active)
+        {
+            tcsetattr(STDIN_FILENO, TCSAFLUSH, &(this->original));
+            this->active = false;
+        }
+    }
+
+private:
+    termios original;
+    bool active;
+};
+
+Raw_mode raw_mode;
+
+void write_all(const char* a_p_data, size_t a_data_size)
+{
+    while (a_data_size > 0)
+    {
+        const ssize_t w = write(STDOUT_FILENO, a_p_data, a_data_size);
+
+        if (w <= 0)
+        {
+            return;
+        }
+
+        a_p_data += w;
+        a_data_size -= static_cast<size_t>(w);
+    }
+}
+
+void cli_write_character(char a_character, void*)
+{
+    write_all(&a_character, 1u);
+}
+
+void cli_write_string(std::string_view a_string, void*)
+{
+    write_all(a_string.data(), a_string.length());
+}
+
+size_t cli_read_character(char* a_p_out, size_t a_buffer_size, void*)
+{
+    pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+
+    if (1 == poll(&fd, 1u, 0) && 0 != (fd.revents & POLLIN))
+    {
+        const ssize_t r = read(STDIN_FILENO, a_p_out, a_buffer_size);
+
+        if (r > 0)
+        {
+            return static_cast<size_t>(r);
+        }
+    }
+
+    if (0 != (fd.revents & (POLLHUP | POLLERR)))
+    {
+        raw_mode.restore();
+        exit(0);
+    }
+
+    return 0;
+}
+
+void cli_wait(void*)
+{
+    pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    poll(&fd, 1u, -1);
+}
+
+// a whole redrawn line goes out in one write
+struct Linux_traits : modules::CLI_traits
+{
+    static constexpr size_t output_buffer_capacity = 256u;
+};
+
+// history log at the path given as the first argument (./sample .cli_history), without it the history is kept in
+// RAM only; records are length (u8) | bytes; a record cut short by a crash is cut off the file when it is loaded,
+// so the records appended after it start on a record boundary
+constexpr off_t history_capacity     = 4096;
+constexpr size_t history_record_size = 256u;
+
+bool history_append(std::string_view a_record, void* a_p_fd)
+{
+    const int fd = *static_cast<int*>(a_p_fd);
+
+    if (a_record.length() >= history_record_size)
+    {
+        return true;
+    }
+
+    if (lseek(fd, 0, SEEK_END) + static_cast<off_t>(a_record.length() + 1u) > history_capacity)
+    {
+        return false;
+    }
+
+    char record[history_record_size];
+    record[0] = static_cast<char>(a_record.length());
+    memcpy(record + 1, a_record.data(), a_record.length());
+
+    const bool ret = static_cast<ssize_t>(a_record.length() + 1u) == write(fd, record, a_record.length() + 1u);
+    fdatasync(fd);
+
+    return ret;
+}
+
+void history_iterate(modules::CLI::History_storage::Record_function a_record, void* a_p_context, void* a_p_fd)
+{
+    const int fd = *static_cast<int*>(a_p_fd);
+
+    uint8_t length = 0;
+    char record[history_record_size];
+    off_t end = 0;
+
+    lseek(fd, 0, SEEK_SET);
+
+    while (1 == read(fd, &length, 1u) && length == read(fd, record, length))
+    {
+        a_record(std::string_view(record, length), a_p_context);
+        end += length + 1;
+    }
+
+    if (lseek(fd, 0, SEEK_END) != end && 0 == ftruncate(fd, end))
+    {
+        fdatasync(fd);
+    }
+}
+
+void history_erase(void* a_p_fd)
+{
+    const int fd = *static_cast<int*>(a_p_fd);
+
+    if (0 == ftruncate(fd, 0))
+    {
+        fdatasync(fd);
+    }
+}
+
+#ifdef CLI_COMMAND_CHAINING
+// "test a ; test_reverse b c", "repeat 3 test a && exit"
+modules::CLI::Command_status cli_callback_test(std::string_view a_argv[], size_t a_argc, void*)
+{
+    for (size_t i = 0; i < a_argc; i++)
+    {
+        write_all(a_argv[i].data(), a_argv[i].length());
+        write_all("\r\n", 2u);
+    }
+
+    return modules::CLI::Command_status::done;
+}
+
+// fails without arguments, so a && after it is skipped
+modules::CLI::Command_status cli_callback_test_reverse(std::string_view a_argv[], size_t a_argc, void*)
+{
+    for (size_t i = 0; i < a_argc; i++)
+    {
+        write_all(a_argv[a_argc - i - 1].data(), a_argv[a_argc - i - 1].length());
+        write_all("\r\n", 2u);
+    }
+
+    return a_argc > 1 ? modules::CLI::Command_status::done : modules::CLI::Command_status::failed;
+}
+
+modules::CLI::Command_status cli_callback_exit(std::string_view[], size_t, void*)
+{
+    raw_mode.restore();
+    exit(0);
+}
+#elif defined(CLI_COMMAND_PARAMETERS)
+void cli_callback_test(std::string_view a_argv[], size_t a_argc, void*)
+{
+    for (size_t i = 0; i < a_argc; i++)
+    {
+        write_all(a_argv[i].data(), a_argv[i].length());
+        write_all("\r\n", 2u);
+    }
+}
+
+void cli_callback_test_reverse(std::string_view a_argv[], size_t a_argc, void*)
+{
+    for (size_t i = 0; i < a_argc; i++)
+    {
+        write_all(a_argv[a_argc - i - 1].data(), a_argv[a_argc - i - 1].length());
+        write_all("\r\n", 2u);
+    }
+}
+
+void cli_callback_exit(std::string_view[], size_t, void*)
+{
+    raw_mode.restore();
+    exit(0);
+}
+#else
+void cli_callback_test(void*)
+{
+    write_all("test\r\n", 6u);
+}
+
+void cli_callback_test_reverse(void*)
+{
+    write_all("test_reverse\r\n", 14u);
+}
+
+void cli_callback_exit(void*)
+{
+    raw_mode.restore();
+    exit(0);
+}
+#endif
+
+} // namespace
+
+int main(int a_argc, char* a_p_argv[])
+{
+    using namespace modules;
+
+#ifdef CLI_SUBCOMMANDS
+    // "print forward a b", "print reverse a b"
+    static constexpr CLI::Callbacks_table<2> print_callbacks = CLI::make_callbacks_table(
+        std::array<CLI::Callback, 2> { CLI::Callback { "forward", cli_callback_test, nullptr },
+                                       CLI::Callback { "reverse", cli_callback_test_reverse, nullptr } });
+
+    static constexpr CLI::Callbacks_table<4> callbacks = CLI::make_callbacks_table(
+        std::array<CLI::Callback, 4> { CLI::Callback { "exit", cli_callback_exit, nullptr },
+                                       CLI::make_group("print", print_callbacks),
+                                       CLI::Callback { "test", cli_callback_test, nullptr },
+                                       CLI::Callback { "test_reverse", cli_callback_test_reverse, nullptr } });
+#else
+    constexpr CLI::Callbacks_table<3> callbacks = CLI::make_callbacks_table(
+        std::array<CLI::Callback, 3> { CLI::Callback { "exit", cli_callback_exit, nullptr },
+                                       CLI::Callback { "test", cli_callback_test, nullptr },
+                                       CLI::Callback { "test_reverse", cli_callback_test_reverse, nullptr } });
+#endif
+
+    Basic_CLI<Linux_traits> cli({ cli_write_character, nullptr },
+                                { cli_write_string, nullptr },
+                                { cli_read_character, nullptr },
+                                { cli_wait, nullptr },
+                                CLI::New_line_mode_flag::cr,
+                                CLI::New_line_mode_flag::cr | CLI::New_line_mode_flag::lf);
+
+    int history_fd = a_argc > 1 ? open(a_p_argv[1], O_RDWR | O_CREAT | O_APPEND, 0600) : -1;
+
+    if (-1 != history_fd)
+    {
+        cli.set_history_storage({ history_append, history_iterate, history_erase, &history_fd });
+    }
+
+    write_all("$ ", 2u);
+
+    while (true)
+    {
+        cli.update("$ ", "> Command not found", callbacks, CLI::Echo::enabled);
+    }
+
+    return 0;
+}
@@ -99,9 +99,10 @@ int main()
 {
     using namespace modules;
 
-    std::array<CLI::Callback, 3> callbacks = { CLI::Callback { "exit", cli_callback_exit, nullptr },
-                                               CLI::Callback { "test", cli_callback_test, nullptr },
-                                               CLI::Callback { "test_reverse", cli_callback_test_reverse, nullptr } };
+    constexpr CLI::Callbacks_table<3> callbacks = CLI::make_callbacks_table(
+        std::array<CLI::Callback, 3> { CLI::Callback { "exit", cli_callback_exit, nullptr },
+                                       CLI::Callback { "test", cli_callback_test, nullptr },
+                                       CLI::Callback { "test_reverse", cli_callback_test_reverse, nullptr } });
 
     CLI cli({ cli_write_character, nullptr },
             { cli_write_string, nullptr },